@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <SimpleBase45.h>
+#include <SimpleBase64.h>
+
+/**
+ * @file codec_check.cpp
+ * @brief SimpleBase64 各指令集实现与 SimpleBase45 的一致性检查，任何一项不符时返回非 0
+ *
+ * 用法：codec_check（也由 ctest 运行）
+ *
+ * - Base64：当前 CPU 支持的每个指令集（scalar/sse41/avx2）分别检查 detail 中的向量内核、encode_to/decode_to、
+ *   encode_into/decode_into、encode_append<wchar_t> 和 stream_encoder/stream_decoder 的任意切分，
+ *   长度覆盖 0~100（含向量块边界 12/16/24/32/43 前后）及若干大块；解码另测混入非法字符和中途出现 '=' 的输入；
+ * - Base45：RFC 9285 的示例、0~100 字节的往返，以及非法长度、非法字符和超出范围的分组。
+ *
+ * 对照用的编码是独立的逐位实现，解码以 detail::decode_scalar 的语义（跳过非法字符，遇到 '=' 结束）为准。
+ */
+
+namespace {
+
+    int failures = 0;
+
+    void check(bool ok, const char* what, std::size_t len, SimpleBase64::isa which = SimpleBase64::isa::scalar) {
+        if (!ok) {
+            ++failures;
+            std::printf("FAIL %s len=%zu isa=%d\n", what, len, static_cast<int>(which));
+        }
+    }
+
+    std::string reference_encode(const std::vector<std::uint8_t>& in) {
+        static constexpr std::string_view chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string out;
+        for (std::size_t i = 0; i < in.size(); i += 3) {
+            const std::size_t n = std::min<std::size_t>(3, in.size() - i);
+            std::uint32_t v     = 0;
+            for (std::size_t k = 0; k < 3; ++k) {
+                v = (v << 8) | (k < n ? in[i + k] : 0u);
+            }
+            for (std::size_t k = 0; k < 4; ++k) {
+                out += k <= n ? chars[(v >> (18 - 6 * k)) & 0x3F] : '=';
+            }
+        }
+        return out;
+    }
+
+    std::vector<std::uint8_t> reference_decode(std::string_view in) {
+        std::vector<std::uint8_t> out(SimpleBase64::max_decoded_size(in.size()));
+        out.resize(SimpleBase64::detail::decode_scalar(in.data(), in.size(), out.data()));
+        return out;
+    }
+
+    std::vector<std::uint8_t> random_bytes(std::mt19937& rng, std::size_t len) {
+        std::vector<std::uint8_t> bytes(len);
+        for (auto& b : bytes) {
+            b = static_cast<std::uint8_t>(rng());
+        }
+        return bytes;
+    }
+
+    std::vector<SimpleBase64::isa> supported_isas() {
+        std::vector<SimpleBase64::isa> isas{SimpleBase64::isa::scalar};
+#ifdef SIMPLEBASE64_X86
+        for (const auto which : {SimpleBase64::isa::sse41, SimpleBase64::isa::avx2}) {
+            if (which <= SimpleBase64::active_isa()) {
+                isas.push_back(which);
+            }
+        }
+#endif
+        return isas;
+    }
+
+    /**
+     * @brief 直接检查向量内核：处理过的前缀必须与对照结果一致，且不越过返回的长度写入
+     */
+    void check_kernels(const std::vector<std::uint8_t>& bytes, const std::string& text, SimpleBase64::isa which) {
+#ifdef SIMPLEBASE64_X86
+        using namespace SimpleBase64::detail;
+        const auto encode_kernel = which == SimpleBase64::isa::avx2 ? encode_avx2 : encode_sse41;
+        const auto decode_kernel = which == SimpleBase64::isa::avx2 ? decode_avx2 : decode_sse41;
+
+        std::string encoded(SimpleBase64::encoded_size(bytes.size()) + 64, '#');
+        const std::size_t consumed = encode_kernel(bytes.data(), bytes.size(), encoded.data());
+        check(consumed % 3 == 0 && consumed <= bytes.size(), "encode kernel consumed", bytes.size(), which);
+        check(encoded.compare(0, consumed / 3 * 4, text, 0, consumed / 3 * 4) == 0, "encode kernel output", bytes.size(), which);
+
+        std::vector<std::uint8_t> decoded(SimpleBase64::max_decoded_size(text.size()) + 64, 0xA5);
+        const std::size_t read = decode_kernel(text.data(), text.size(), decoded.data());
+        check(read % 4 == 0 && read <= text.size(), "decode kernel consumed", text.size(), which);
+        const auto expected = reference_decode(std::string_view(text).substr(0, read));
+        check(std::equal(expected.begin(), expected.end(), decoded.begin()), "decode kernel output", text.size(), which);
+#else
+        (void)bytes, (void)text, (void)which;
+#endif
+    }
+
+    void check_base64_length(std::mt19937& rng, std::size_t len) {
+        const auto bytes      = random_bytes(rng, len);
+        const std::string ref = reference_encode(bytes);
+
+        for (const auto which : supported_isas()) {
+            if (which != SimpleBase64::isa::scalar) {
+                check_kernels(bytes, ref, which);
+            }
+
+            std::string encoded(SimpleBase64::encoded_size(len), '#');
+            SimpleBase64::encode_to(encoded.data(), bytes.data(), len, which);
+            check(encoded == ref, "encode_to", len, which);
+
+            // 解码缓冲区之后放哨兵，检查没有越过 max_decoded_size 写入
+            constexpr std::size_t guard = 64;
+            std::vector<std::uint8_t> decoded(SimpleBase64::max_decoded_size(ref.size()) + guard, 0xA5);
+            const std::size_t size = SimpleBase64::decode_to(decoded.data(), ref.data(), ref.size(), which);
+            check(size == len && std::equal(bytes.begin(), bytes.end(), decoded.begin()), "decode_to", len, which);
+            check(std::all_of(decoded.end() - guard, decoded.end(), [](std::uint8_t b) { return b == 0xA5; }), "decode_to guard", len, which);
+
+            // 混入非法字符：结果与标量语义一致
+            std::string noisy = ref;
+            for (std::size_t i = 0; i < noisy.size(); i += 1 + rng() % 7) {
+                noisy.insert(noisy.begin() + static_cast<std::ptrdiff_t>(i), "\n !\x80~"[rng() % 5]);
+            }
+            const auto noisyRef = reference_decode(noisy);
+            check(noisyRef == bytes, "reference skips invalid characters", len);
+            decoded.assign(SimpleBase64::max_decoded_size(noisy.size()), 0);
+            decoded.resize(SimpleBase64::decode_to(decoded.data(), noisy.data(), noisy.size(), which));
+            check(decoded == noisyRef, "decode_to with invalid characters", len, which);
+
+            // 中途出现 '='：之后的内容全部忽略
+            if (!ref.empty()) {
+                std::string early = ref + ref;
+                early.insert(early.begin() + static_cast<std::ptrdiff_t>(rng() % early.size()), '=');
+                const auto earlyRef = reference_decode(early);
+                decoded.assign(SimpleBase64::max_decoded_size(early.size()), 0);
+                decoded.resize(SimpleBase64::decode_to(decoded.data(), early.data(), early.size(), which));
+                check(decoded == earlyRef, "decode_to with '='", len, which);
+            }
+        }
+
+        // 以下接口按 active_isa 分派
+        std::string into(SimpleBase64::encoded_size(len), '#');
+        check(SimpleBase64::encode_into(bytes, into) == ref.size() && into == ref, "encode_into", len);
+        std::vector<std::uint8_t> exact(SimpleBase64::decoded_size(ref));
+        check(SimpleBase64::decode_into(ref, exact) == len && exact == bytes, "decode_into exact buffer", len);
+
+        std::wstring wide;
+        SimpleBase64::encode_append(wide, bytes.data(), len);
+        check(wide == std::wstring(ref.begin(), ref.end()), "encode_append<wchar_t>", len);
+
+        // 流式接口：随机切分
+        SimpleBase64::stream_encoder encoder;
+        std::string streamed;
+        for (std::size_t i = 0; i < len;) {
+            const std::size_t n = std::min<std::size_t>(len - i, rng() % 50);
+            std::string out(SimpleBase64::stream_encoder::max_update_size(n), '#');
+            out.resize(encoder.update({bytes.data() + i, n}, out));
+            streamed += out;
+            i += n;
+        }
+        std::string tail(4, '#');
+        tail.resize(encoder.finish(tail));
+        check(streamed + tail == ref, "stream_encoder", len);
+
+        std::string noisy = ref + "=" + ref;
+        noisy.insert(noisy.begin() + static_cast<std::ptrdiff_t>(rng() % noisy.size()), '\n');
+        SimpleBase64::stream_decoder decoder;
+        std::vector<std::uint8_t> stream;
+        for (std::size_t i = 0; i < noisy.size();) {
+            const std::size_t n = std::min<std::size_t>(noisy.size() - i, rng() % 70);
+            std::vector<std::uint8_t> out(SimpleBase64::stream_decoder::max_update_size(n));
+            out.resize(decoder.update(std::string_view(noisy).substr(i, n), out));
+            stream.insert(stream.end(), out.begin(), out.end());
+            i += n;
+        }
+        check(stream == reference_decode(noisy), "stream_decoder", len);
+    }
+
+    template <typename F>
+    bool throws(F&& f) {
+        try {
+            f();
+        } catch (const std::invalid_argument&) {
+            return true;
+        }
+        return false;
+    }
+
+    void check_base45(std::mt19937& rng) {
+        // RFC 9285 第 4.3、4.4 节的示例
+        const std::pair<std::string_view, std::string_view> vectors[] = {
+            {"AB", "BB8"}, {"Hello!!", "%69 VD92EX0"}, {"base-45", "UJCLQE7W581"}, {"ietf!", "QED8WEX0"}};
+        for (const auto& [plain, text] : vectors) {
+            const std::vector<std::uint8_t> bytes(plain.begin(), plain.end());
+            check(SimpleBase45::encode(bytes) == text, "base45 rfc encode", plain.size());
+            check(SimpleBase45::decode(text) == bytes, "base45 rfc decode", plain.size());
+        }
+
+        for (std::size_t len = 0; len <= 100; ++len) {
+            const auto bytes = random_bytes(rng, len);
+            const auto text  = SimpleBase45::encode(bytes);
+            check(text.size() == SimpleBase45::encoded_size(len), "base45 encoded_size", len);
+            check(SimpleBase45::decode(text) == bytes, "base45 round trip", len);
+
+            std::wstring wide;
+            SimpleBase45::encode_append(wide, bytes.data(), len);
+            check(wide == std::wstring(text.begin(), text.end()), "base45 encode_append<wchar_t>", len);
+        }
+
+        check(throws([] { (void)SimpleBase45::decode("BB8B"); }), "base45 invalid length", 4);
+        check(throws([] { (void)SimpleBase45::decode("BB#"); }), "base45 invalid character", 3);
+        check(throws([] { (void)SimpleBase45::decode("bb8"); }), "base45 lowercase", 3);
+        check(throws([] { (void)SimpleBase45::decode("GGW"); }), "base45 group out of range", 3);
+        check(throws([] { (void)SimpleBase45::decode(":6"); }), "base45 tail out of range", 2);
+    }
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(20240601);
+    for (std::size_t len = 0; len <= 100; ++len) {
+        check_base64_length(rng, len);
+    }
+    for (const std::size_t len : {255, 256, 257, 1000, 4095, 4096, 4097, 65537}) {
+        check_base64_length(rng, len);
+    }
+    check_base45(rng);
+
+    std::printf("codec_check: active isa %d, %d failure(s)\n", static_cast<int>(SimpleBase64::active_isa()), failures);
+    return failures == 0 ? 0 : 1;
+}
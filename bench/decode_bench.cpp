@@ -0,0 +1,87 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <QDir>
+#include <QStringList>
+
+#include "convert.h"
+
+/**
+ * @file decode_bench.cpp
+ * @brief 对比旧的全分辨率彩色解码与 convert::QRcode_to_byte 多分辨率解码的耗时和图像内存
+ *
+ * 用法：decode_bench [图片目录]，默认 test_samples/QRCode2text。
+ * 旧实现：IMREAD_COLOR 读入彩色图，cvtColor 转灰度后识别，彩色图和灰度图同时驻留；
+ * 新实现：直接读灰度，大图先缩小识别，失败才回退原图。
+ * 两种实现的识别结果逐条比对，不一致时返回非零。
+ */
+
+namespace {
+
+    struct legacy_result {
+        std::string text;
+        bool ok = false;
+        std::size_t peak_bytes = 0;
+    };
+
+    legacy_result legacy_QRcode_to_byte(const std::string& file_path) {
+        const cv::Mat img = cv::imread(file_path, cv::IMREAD_COLOR);
+        if (img.empty()) {
+            return {};
+        }
+
+        cv::Mat grayImg;
+        cv::cvtColor(img, grayImg, cv::COLOR_BGR2GRAY);
+
+        const ZXing::ImageView imageView(grayImg.data, grayImg.cols, grayImg.rows, ZXing::ImageFormat::Lum);
+        const auto result = ZXing::ReadBarcode(imageView);
+        return {result.text(), result.isValid(), img.total() * img.elemSize() + grayImg.total() * grayImg.elemSize()};
+    }
+
+    template <typename F>
+    double measure_ms(int iterations, F&& f) {
+        const auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            f();
+        }
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(end - begin).count() / iterations;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const QDir dir(argc > 1 ? QString::fromLocal8Bit(argv[1]) : QStringLiteral("test_samples/QRCode2text"));
+    const QStringList images = dir.entryList({"*.png", "*.jpg", "*.jpeg", "*.bmp"}, QDir::Files, QDir::Name);
+    if (images.isEmpty()) {
+        std::fprintf(stderr, "no images in %s\n", qPrintable(dir.absolutePath()));
+        return 2;
+    }
+
+    constexpr double MiB = 1024.0 * 1024.0;
+    int mismatches = 0;
+    std::printf("%-24s %12s %12s %8s %12s %12s %6s\n", "image", "legacy(ms)", "multires(ms)", "speedup", "legacy(MiB)",
+        "multires(MiB)", "scale");
+    for (const QString& name : images) {
+        const std::string path = dir.filePath(name).toLocal8Bit().toStdString();
+
+        const auto expected = legacy_QRcode_to_byte(path);
+        convert::decode_trace trace;
+        const auto actual = convert::QRcode_to_byte(path, {}, &trace);
+        if (expected.ok != static_cast<bool>(actual) || (expected.ok && expected.text != actual.text)) {
+            std::printf("%-24s result mismatch\n", qPrintable(name));
+            ++mismatches;
+            continue;
+        }
+
+        const int iterations = expected.peak_bytes >= 64 * MiB ? 3 : 10;
+        const double legacy  = measure_ms(iterations, [&] { (void)legacy_QRcode_to_byte(path); });
+        const double multi   = measure_ms(iterations, [&] { (void)convert::QRcode_to_byte(path); });
+        std::printf("%-24s %12.1f %12.1f %7.2fx %12.1f %12.1f %6d\n", qPrintable(name), legacy, multi, legacy / multi,
+            expected.peak_bytes / MiB, trace.peak_bytes / MiB, trace.scale);
+    }
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "convert.h"
+
+/**
+ * @file rasterize_bench.cpp
+ * @brief 对比旧的逐像素光栅化与 convert::rasterize_modules 的耗时
+ *
+ * 旧实现：让 ZXing 按目标尺寸放大后再逐像素 bitMatrix.get(x, y) 写入 QImage；
+ * 新实现：只生成模块矩阵，按模块游程 memset 并复制重复扫描线。
+ * 两种实现的输出逐像素比对，不一致时返回非零。
+ */
+
+namespace {
+
+    QImage legacy_byte_to_QRCode_qimage(const std::string& text, const convert::QRcode_create_config qrcode_config) {
+        ZXing::MultiFormatWriter writer(qrcode_config.format);
+        writer.setMargin(qrcode_config.margin);
+
+        const auto bitMatrix = writer.encode(text, qrcode_config.target_width, qrcode_config.target_height);
+        const auto width     = bitMatrix.width();
+        const auto height    = bitMatrix.height();
+
+        QImage image(width, height, QImage::Format_Grayscale8);
+
+        for (int y = 0; y < height; ++y) {
+            uchar* line = image.scanLine(y);
+            for (int x = 0; x < width; ++x) {
+                line[x] = bitMatrix.get(x, y) ? 0x00 : std::numeric_limits<uchar>::max();
+            }
+        }
+
+        return image;
+    }
+
+    template <typename F>
+    double measure_us(int iterations, F&& f) {
+        const auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            f();
+        }
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::micro>(end - begin).count() / iterations;
+    }
+
+    bool same_pixels(const QImage& a, const QImage& b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (int y = 0; y < a.height(); ++y) {
+            if (std::memcmp(a.constScanLine(y), b.constScanLine(y), a.width()) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+} // namespace
+
+int main() {
+    struct bench_case {
+        const char* name;
+        ZXing::BarcodeFormat format;
+        std::size_t payload;
+        int size;
+    };
+
+    // 常用尺寸与海报尺寸
+    const std::vector<bench_case> cases{
+        {"QRCode 300",         ZXing::BarcodeFormat::QRCode,     200,  300},
+        {"QRCode 1000",        ZXing::BarcodeFormat::QRCode,     1000, 1000},
+        {"QRCode 2000",        ZXing::BarcodeFormat::QRCode,     2000, 2000},
+        {"QRCode 4000 poster", ZXing::BarcodeFormat::QRCode,     2000, 4000},
+        {"DataMatrix 2000",    ZXing::BarcodeFormat::DataMatrix, 1000, 2000},
+        {"Code128 2000",       ZXing::BarcodeFormat::Code128,    40,   2000},
+    };
+
+    int mismatches = 0;
+    std::printf("%-20s %14s %14s %8s\n", "case", "legacy(us)", "modules(us)", "speedup");
+    for (const auto& c : cases) {
+        std::string text;
+        text.reserve(c.payload);
+        for (std::size_t i = 0; i < c.payload; ++i) {
+            text.push_back(static_cast<char>('A' + i * 7 % 26));
+        }
+        const convert::QRcode_create_config config{c.size, c.size, c.format, 1};
+
+        const QImage expected = legacy_byte_to_QRCode_qimage(text, config);
+        const QImage actual   = convert::byte_to_QRCode_qimage(text, config);
+        if (!same_pixels(expected, actual)) {
+            std::printf("%-20s output mismatch\n", c.name);
+            ++mismatches;
+            continue;
+        }
+
+        const int iterations = c.size >= 2000 ? 10 : 50;
+        const double legacy  = measure_us(iterations, [&] { (void)legacy_byte_to_QRCode_qimage(text, config); });
+        const double modules = measure_us(iterations, [&] { (void)convert::byte_to_QRCode_qimage(text, config); });
+        std::printf("%-20s %14.1f %14.1f %7.2fx\n", c.name, legacy, modules, legacy / modules);
+    }
+
+    return mismatches == 0 ? 0 : 1;
+}
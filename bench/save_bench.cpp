@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <QDir>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include "convert.h"
+#include "image_writer.h"
+
+/**
+ * @file save_bench.cpp
+ * @brief 对比生成结果以各种格式写盘的吞吐
+ *
+ * 用法：save_bench [条码数量，默认 10000] [图片边长，默认 300]
+ * 先生成指定数量、内容各不相同的 QRCode，再分别以 png（QImage::save，旧实现）、
+ * png1（压缩等级 1/6/9）、pbm 和 modules 写入临时目录，输出每秒文件数、写入字节数和相对旧实现的加速比。
+ * png1 写出的文件会读回逐像素比对，不一致时返回非零。
+ */
+
+namespace {
+
+    struct format_case {
+        const char* name;
+        convert::image_save_options options;
+    };
+
+    bool same_pixels(const QImage& a, const QImage& b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        const QImage ga = a.convertToFormat(QImage::Format_Grayscale8);
+        const QImage gb = b.convertToFormat(QImage::Format_Grayscale8);
+        for (int y = 0; y < ga.height(); ++y) {
+            if (std::memcmp(ga.constScanLine(y), gb.constScanLine(y), ga.width()) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const int count = argc > 1 ? std::max(1, std::atoi(argv[1])) : 10000;
+    const int side  = argc > 2 ? std::max(21, std::atoi(argv[2])) : 300;
+
+    std::vector<QImage> images;
+    images.reserve(count);
+    const convert::QRcode_create_config config{side, side, ZXing::BarcodeFormat::QRCode, 1};
+    for (int i = 0; i < count; ++i) {
+        // 长度和内容各不相同，覆盖多个 QR 版本
+        std::string text = "Lab2QRCode save bench #" + std::to_string(i) + " ";
+        text.append(static_cast<std::size_t>(i % 200), static_cast<char>('a' + i % 26));
+        images.push_back(convert::byte_to_QRCode_qimage(text, config));
+    }
+
+    const std::vector<format_case> cases{
+        {"png (QImage::save)", {convert::image_format::png}},
+        {"png1 level 1",       {convert::image_format::png_1bit, 1}},
+        {"png1 level 6",       {convert::image_format::png_1bit, 6}},
+        {"png1 level 9",       {convert::image_format::png_1bit, 9}},
+        {"pbm",                {convert::image_format::pbm}},
+        {"modules",            {convert::image_format::modules}},
+    };
+
+    constexpr double MiB = 1024.0 * 1024.0;
+    int mismatches       = 0;
+    double baseline      = 0;
+    std::printf("%d codes, %dx%d\n", count, side, side);
+    std::printf("%-20s %12s %12s %12s %8s\n", "format", "files/s", "MiB written", "bytes/file", "speedup");
+    for (const auto& c : cases) {
+        QTemporaryDir dir;
+        const QString suffix = c.options.suffix();
+
+        const auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; ++i) {
+            if (!convert::write_image(images[i], dir.filePath(QString("%1.%2").arg(i).arg(suffix)), c.options)) {
+                std::fprintf(stderr, "%s: write failed\n", c.name);
+                return 2;
+            }
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        qint64 bytes = 0;
+        for (const QFileInfo& info : QDir(dir.path()).entryInfoList(QDir::Files)) {
+            bytes += info.size();
+        }
+        if (c.options.format == convert::image_format::png_1bit) {
+            for (int i = 0; i < count; i += std::max(1, count / 100)) {
+                if (!same_pixels(images[i], QImage(dir.filePath(QString("%1.png").arg(i))))) {
+                    std::printf("%-20s pixel mismatch at #%d\n", c.name, i);
+                    ++mismatches;
+                    break;
+                }
+            }
+        }
+
+        const double rate = count / seconds;
+        if (baseline == 0) {
+            baseline = rate;
+        }
+        std::printf("%-20s %12.0f %12.2f %12.0f %7.2fx\n", c.name, rate, bytes / MiB, static_cast<double>(bytes) / count, rate / baseline);
+    }
+
+    return mismatches == 0 ? 0 : 1;
+}
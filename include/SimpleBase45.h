@@ -0,0 +1,106 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Base45（RFC 9285）：字母表恰好是 QR 码字母数字模式的 45 个字符，
+// 在 QR 码中每字节约 8.25 位，Base64 走字节模式则约 10.7 位
+namespace SimpleBase45 {
+
+    inline constexpr std::string_view base45_chars = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ $%*+-./:";
+
+    // 编码 len 字节后的字符数：每 2 字节 3 个字符，末尾单字节 2 个字符
+    constexpr std::size_t encoded_size(std::size_t len) { return len / 2 * 3 + len % 2 * 2; }
+
+    // 解码 len 个字符最多得到的字节数
+    constexpr std::size_t max_decoded_size(std::size_t len) { return len / 3 * 2 + (len % 3 == 2 ? 1 : 0); }
+
+    namespace detail {
+
+        // 字符 -> 值，-1 表示不属于 Base45 字母表
+        inline constexpr auto decode_table = [] {
+            std::array<std::int8_t, 256> table{};
+            table.fill(-1);
+            for (std::size_t i = 0; i < base45_chars.size(); ++i)
+                table[static_cast<unsigned char>(base45_chars[i])] = static_cast<std::int8_t>(i);
+            return table;
+        }();
+
+        inline int value_of(char ch) {
+            const int v = decode_table[static_cast<unsigned char>(ch)];
+            if (v < 0)
+                throw std::invalid_argument("SimpleBase45: invalid character");
+            return v;
+        }
+
+    } // namespace detail
+
+    // 编码到 dst，dst 至少有 encoded_size(len) 个字符
+    template <typename CharT>
+    inline void encode_to(CharT* dst, const std::uint8_t* src, std::size_t len) {
+        std::size_t i = 0;
+        for (; i + 2 <= len; i += 2) {
+            // RFC 9285：两字节按大端组成 n，依次写出 n % 45、n / 45 % 45、n / 2025
+            std::uint32_t n = (std::uint32_t{src[i]} << 8) | src[i + 1];
+            *dst++ = static_cast<CharT>(base45_chars[n % 45]);
+            n /= 45;
+            *dst++ = static_cast<CharT>(base45_chars[n % 45]);
+            *dst++ = static_cast<CharT>(base45_chars[n / 45]);
+        }
+        if (i < len) {
+            *dst++ = static_cast<CharT>(base45_chars[src[i] % 45]);
+            *dst++ = static_cast<CharT>(base45_chars[src[i] / 45]);
+        }
+    }
+
+    // 解码到 dst，dst 至少有 max_decoded_size(len) 字节；返回写入的字节数
+    // 与 Base64 不同，Base45 没有可以跳过的字符，非法字符、非法长度或超出范围的分组直接抛出 std::invalid_argument
+    inline std::size_t decode_to(std::uint8_t* dst, const char* src, std::size_t len) {
+        if (len % 3 == 1)
+            throw std::invalid_argument("SimpleBase45: invalid length");
+
+        std::uint8_t* const begin = dst;
+        std::size_t i             = 0;
+        for (; i + 3 <= len; i += 3) {
+            const std::uint32_t n = detail::value_of(src[i]) + detail::value_of(src[i + 1]) * 45u + detail::value_of(src[i + 2]) * 2025u;
+            if (n > 0xFFFF)
+                throw std::invalid_argument("SimpleBase45: value out of range");
+            *dst++ = static_cast<std::uint8_t>(n >> 8);
+            *dst++ = static_cast<std::uint8_t>(n);
+        }
+        if (i < len) {
+            const std::uint32_t n = detail::value_of(src[i]) + detail::value_of(src[i + 1]) * 45u;
+            if (n > 0xFF)
+                throw std::invalid_argument("SimpleBase45: value out of range");
+            *dst++ = static_cast<std::uint8_t>(n);
+        }
+        return static_cast<std::size_t>(dst - begin);
+    }
+
+    // 编码，结果追加到 out 末尾；CharT 可以是 wchar_t，直接生成 ZXing 需要的宽字符串
+    template <typename CharT>
+    inline void encode_append(std::basic_string<CharT>& out, const std::uint8_t* data, std::size_t len) {
+        const std::size_t start = out.size();
+        out.resize(start + encoded_size(len));
+        encode_to(out.data() + start, data, len);
+    }
+
+    // 编码
+    inline std::string encode(std::span<const std::uint8_t> data) {
+        std::string ret;
+        encode_append(ret, data.data(), data.size());
+        return ret;
+    }
+
+    // 解码
+    inline std::vector<std::uint8_t> decode(std::string_view str) {
+        std::vector<std::uint8_t> ret(max_decoded_size(str.size()));
+        ret.resize(decode_to(ret.data(), str.data(), str.size()));
+        return ret;
+    }
+
+} // namespace SimpleBase45
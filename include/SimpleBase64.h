@@ -1,59 +1,502 @@
 #pragma once
+#include <algorithm>
+#include <array>
 #include <cstdint>
+#include <cstring>
+#include <span>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMPLEBASE64_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang 需要按函数开启指令集，MSVC 的内建函数不需要
+#if defined(__GNUC__) || defined(__clang__)
+#define SIMPLEBASE64_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SIMPLEBASE64_TARGET(isa)
+#endif
+
 namespace SimpleBase64 {
 
     static const char* base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
                                       "abcdefghijklmnopqrstuvwxyz"
                                       "0123456789+/";
 
+    // 编解码使用的指令集，运行时按 CPU 支持情况选择，结果与标量实现逐字节一致
+    enum class isa {
+        scalar,
+        sse41, // SSSE3 + SSE4.1，每次 12 字节 <-> 16 字符
+        avx2,  // 每次 24 字节 <-> 32 字符
+    };
+
+    inline isa detect_isa() {
+#ifdef SIMPLEBASE64_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+        __cpuid(info, 1);
+        const bool ssse3   = info[2] & (1 << 9);
+        const bool sse41   = info[2] & (1 << 19);
+        const bool osxsave = info[2] & (1 << 27);
+        const bool avx     = info[2] & (1 << 28);
+        bool avx2          = false;
+        if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+            __cpuidex(info, 7, 0);
+            avx2 = info[1] & (1 << 5);
+        }
+        if (avx2)
+            return isa::avx2;
+        if (ssse3 && sse41)
+            return isa::sse41;
+#else
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return isa::avx2;
+        if (__builtin_cpu_supports("ssse3") && __builtin_cpu_supports("sse4.1"))
+            return isa::sse41;
+#endif
+#endif
+        return isa::scalar;
+    }
+
+    // 当前 CPU 可用的最快指令集，只检测一次
+    inline isa active_isa() {
+        static const isa detected = detect_isa();
+        return detected;
+    }
+
+    // 编码 len 字节后的字符数（含填充）
+    constexpr std::size_t encoded_size(std::size_t len) { return (len + 2) / 3 * 4; }
+
+    // 解码 len 个字符最多得到的字节数
+    constexpr std::size_t max_decoded_size(std::size_t len) { return (len + 3) / 4 * 3; }
+
+    namespace detail {
+
+        // 字符 -> 6 位值，-1 表示不属于 Base64 字母表
+        inline constexpr auto decode_table = [] {
+            std::array<std::int8_t, 256> table{};
+            table.fill(-1);
+            for (int i = 0; i < 26; ++i) {
+                table['A' + i] = static_cast<std::int8_t>(i);
+                table['a' + i] = static_cast<std::int8_t>(26 + i);
+            }
+            for (int i = 0; i < 10; ++i)
+                table['0' + i] = static_cast<std::int8_t>(52 + i);
+            table['+'] = 62;
+            table['/'] = 63;
+            return table;
+        }();
+
+        // 完整的标量编码，写入 encoded_size(len) 个字符
+        inline void encode_scalar(const std::uint8_t* src, std::size_t len, char* dst) {
+            std::size_t i = 0;
+            for (; i + 3 <= len; i += 3) {
+                const std::uint32_t v = (std::uint32_t{src[i]} << 16) | (std::uint32_t{src[i + 1]} << 8) | src[i + 2];
+                *dst++ = base64_chars[(v >> 18) & 0x3F];
+                *dst++ = base64_chars[(v >> 12) & 0x3F];
+                *dst++ = base64_chars[(v >> 6) & 0x3F];
+                *dst++ = base64_chars[v & 0x3F];
+            }
+            if (const std::size_t rest = len - i; rest > 0) {
+                const std::uint32_t v = (std::uint32_t{src[i]} << 16) | (rest == 2 ? std::uint32_t{src[i + 1]} << 8 : 0);
+                *dst++ = base64_chars[(v >> 18) & 0x3F];
+                *dst++ = base64_chars[(v >> 12) & 0x3F];
+                *dst++ = rest == 2 ? base64_chars[(v >> 6) & 0x3F] : '=';
+                *dst++ = '=';
+            }
+        }
+
+        // 标量解码的进度，流式解码时跨调用保存
+        struct decode_state {
+            std::uint32_t val = 0;
+            int valb          = -8;    // -8 表示没有未输出的位，正好处在 4 字符组的边界上
+            bool done         = false; // 已遇到 '='
+        };
+
+        // 标量解码：跳过字母表以外的字符，遇到 '=' 结束；返回写入的字节数
+        inline std::size_t decode_scalar(decode_state& state, const char* src, std::size_t len, std::uint8_t* dst) {
+            std::uint8_t* const begin = dst;
+            for (std::size_t i = 0; i < len && !state.done; ++i) {
+                const auto c = static_cast<unsigned char>(src[i]);
+                const int v  = decode_table[c];
+                if (v < 0) {
+                    if (c == '=')
+                        state.done = true; // padding
+                    continue;              // skip invalid chars
+                }
+                state.val = ((state.val << 6) | static_cast<std::uint32_t>(v)) & 0xFFFFFF;
+                state.valb += 6;
+                if (state.valb >= 0) {
+                    *dst++ = static_cast<std::uint8_t>((state.val >> state.valb) & 0xFF);
+                    state.valb -= 8;
+                }
+            }
+            return static_cast<std::size_t>(dst - begin);
+        }
+
+        inline std::size_t decode_scalar(const char* src, std::size_t len, std::uint8_t* dst) {
+            decode_state state;
+            return decode_scalar(state, src, len, dst);
+        }
+
+#ifdef SIMPLEBASE64_X86
+        // 以下向量实现参考 W. Muła 与 D. Lemire 的 pshufb 查表法
+
+        // 每 3 字节拆成 4 个 6 位索引（按 32 位分组）
+        SIMPLEBASE64_TARGET("ssse3,sse4.1")
+        inline __m128i encode_split_sse(__m128i in) {
+            in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+            const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+            const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+            const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+            const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+            return _mm_or_si128(t1, t3);
+        }
+
+        // 6 位索引 -> ASCII
+        SIMPLEBASE64_TARGET("ssse3,sse4.1")
+        inline __m128i encode_lookup_sse(__m128i indices) {
+            __m128i result     = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+            const __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+            result             = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+            const __m128i shift = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+            return _mm_add_epi8(_mm_shuffle_epi8(shift, result), indices);
+        }
+
+        // 编码尽可能多的完整 12 字节块，返回消耗的输入字节数（3 的倍数）
+        SIMPLEBASE64_TARGET("ssse3,sse4.1")
+        inline std::size_t encode_sse41(const std::uint8_t* src, std::size_t len, char* dst) {
+            std::size_t i = 0;
+            for (; i + 16 <= len; i += 12, dst += 16) {
+                const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), encode_lookup_sse(encode_split_sse(in)));
+            }
+            return i;
+        }
+
+        SIMPLEBASE64_TARGET("avx2")
+        inline std::size_t encode_avx2(const std::uint8_t* src, std::size_t len, char* dst) {
+            const __m256i shuffle = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                                     1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+            const __m256i shift = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0, 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+            std::size_t i = 0;
+            // 两个 128 位通道各取 12 字节，第二次加载读到 i + 28
+            for (; i + 28 <= len; i += 24, dst += 32) {
+                const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 12));
+                __m256i in       = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+                in               = _mm256_shuffle_epi8(in, shuffle);
+                const __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+                const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+                const __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+                const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+                const __m256i indices = _mm256_or_si256(t1, t3);
+
+                __m256i result     = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+                const __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+                result             = _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+                result             = _mm256_add_epi8(_mm256_shuffle_epi8(shift, result), indices);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), result);
+            }
+            return i;
+        }
+
+        // 解码尽可能多的 16 字符块；遇到含字母表以外字符（包括 '='）的块即停下，交给标量实现。
+        // dst 至少有 max_decoded_size(len) 字节；返回消耗的字符数（4 的倍数），输出为其 3/4
+        SIMPLEBASE64_TARGET("ssse3,sse4.1")
+        inline std::size_t decode_sse41(const char* src, std::size_t len, std::uint8_t* dst) {
+            const __m128i lut_lo  = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+            const __m128i lut_hi  = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+            const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+            const __m128i mask_2f = _mm_set1_epi8(0x2f);
+            const __m128i pack    = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+            std::size_t i = 0;
+            // 每块写出 16 字节（有效 12 字节），剩余至少 22 个字符时保证不越过 dst 末尾
+            for (; i + 22 <= len; i += 16, dst += 12) {
+                __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+                const __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(in, 4), mask_2f);
+                const __m128i lo_nibbles = _mm_and_si128(in, mask_2f);
+                const __m128i lo         = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+                const __m128i hi         = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+                if (!_mm_testz_si128(lo, hi)) {
+                    break;
+                }
+                const __m128i eq_2f = _mm_cmpeq_epi8(in, mask_2f);
+                const __m128i roll  = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nibbles));
+                in                  = _mm_add_epi8(in, roll);
+
+                const __m128i merged = _mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140));
+                const __m128i packed = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_shuffle_epi8(packed, pack));
+            }
+            return i;
+        }
+
+        SIMPLEBASE64_TARGET("avx2")
+        inline std::size_t decode_avx2(const char* src, std::size_t len, std::uint8_t* dst) {
+            const __m256i lut_lo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+                                                    0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+            const __m256i lut_hi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                                    0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+            const __m256i lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                                                      0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+            const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+            const __m256i pack    = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                                     2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+            const __m256i compact = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+
+            std::size_t i = 0;
+            // 每块写出 32 字节（有效 24 字节），剩余至少 43 个字符时保证不越过 dst 末尾
+            for (; i + 43 <= len; i += 32, dst += 24) {
+                __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+
+                const __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(in, 4), mask_2f);
+                const __m256i lo_nibbles = _mm256_and_si256(in, mask_2f);
+                const __m256i lo         = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+                const __m256i hi         = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+                if (!_mm256_testz_si256(lo, hi)) {
+                    break;
+                }
+                const __m256i eq_2f = _mm256_cmpeq_epi8(in, mask_2f);
+                const __m256i roll  = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles));
+                in                  = _mm256_add_epi8(in, roll);
+
+                const __m256i merged = _mm256_maddubs_epi16(in, _mm256_set1_epi32(0x01400140));
+                __m256i packed       = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+                packed               = _mm256_shuffle_epi8(packed, pack);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm256_permutevar8x32_epi32(packed, compact));
+            }
+            return i;
+        }
+#endif
+
+    } // namespace detail
+
+    // 编码到 dst，dst 至少有 encoded_size(len) 个字符
+    inline void encode_to(char* dst, const std::uint8_t* src, std::size_t len, isa which = active_isa()) {
+        std::size_t done = 0;
+#ifdef SIMPLEBASE64_X86
+        if (which == isa::avx2) {
+            done = detail::encode_avx2(src, len, dst);
+        }
+        if (which >= isa::sse41) {
+            done += detail::encode_sse41(src + done, len - done, dst + done / 3 * 4);
+        }
+#else
+        (void)which;
+#endif
+        detail::encode_scalar(src + done, len - done, dst + done / 3 * 4);
+    }
+
+    namespace detail {
+        // 先用向量实现处理尽可能多的完整块，再由标量实现从干净的状态接着解码；返回消耗的字符数
+        inline std::size_t decode_blocks(const char* src, std::size_t len, std::uint8_t* dst, isa which) {
+            std::size_t done = 0;
+#ifdef SIMPLEBASE64_X86
+            if (which == isa::avx2) {
+                done = decode_avx2(src, len, dst);
+            }
+            if (which >= isa::sse41) {
+                done += decode_sse41(src + done, len - done, dst + done / 4 * 3);
+            }
+#else
+            (void)src, (void)len, (void)dst, (void)which;
+#endif
+            return done;
+        }
+    }
+
+    // 解码到 dst，dst 至少有 max_decoded_size(len) 字节；返回写入的字节数
+    inline std::size_t decode_to(std::uint8_t* dst, const char* src, std::size_t len, isa which = active_isa()) {
+        const std::size_t done = detail::decode_blocks(src, len, dst, which);
+        return done / 4 * 3 + detail::decode_scalar(src + done, len - done, dst + done / 4 * 3);
+    }
+
+    // 精确的解码长度：'=' 之前属于字母表的字符数 * 6 / 8
+    inline std::size_t decoded_size(std::string_view str) {
+        std::size_t valid = 0;
+        for (const char ch : str) {
+            const auto c = static_cast<unsigned char>(ch);
+            if (detail::decode_table[c] >= 0)
+                ++valid;
+            else if (c == '=')
+                break;
+        }
+        return valid * 6 / 8;
+    }
+
+    // 编码到调用方提供的缓冲区，out 不小于 encoded_size(in.size())；返回写入的字符数
+    inline std::size_t encode_into(std::span<const std::uint8_t> in, std::span<char> out) {
+        const std::size_t size = encoded_size(in.size());
+        if (out.size() < size)
+            throw std::length_error("SimpleBase64::encode_into: output buffer too small");
+        encode_to(out.data(), in.data(), in.size());
+        return size;
+    }
+
+    // 解码到调用方提供的缓冲区，out 不小于 decoded_size(in)；返回写入的字节数
+    inline std::size_t decode_into(std::string_view in, std::span<std::uint8_t> out) {
+        if (out.size() >= max_decoded_size(in.size()))
+            return decode_to(out.data(), in.data(), in.size());
+
+        // 缓冲区按精确长度给出时，向量实现的整块写入可能越界，先解到栈上再复制末尾
+        const std::size_t size = decoded_size(in);
+        if (out.size() < size)
+            throw std::length_error("SimpleBase64::decode_into: output buffer too small");
+
+        detail::decode_state state;
+        std::size_t written = 0;
+        std::size_t i       = 0;
+        while (i < in.size() && !state.done) {
+            std::uint8_t buffer[max_decoded_size(1024)];
+            const std::size_t n = std::min<std::size_t>(1024, in.size() - i);
+            const std::size_t produced = detail::decode_scalar(state, in.data() + i, n, buffer);
+            if (produced > 0)
+                std::memcpy(out.data() + written, buffer, produced);
+            written += produced;
+            i += n;
+        }
+        return written;
+    }
+
+    // 流式编码：按块输入任意长度的数据，最后调用 finish 补齐填充
+    class stream_encoder {
+    public:
+        // update 一次最多写出的字符数
+        static constexpr std::size_t max_update_size(std::size_t len) { return (len + 2) / 3 * 4; }
+
+        // 编码一块数据，out 不小于 max_update_size(in.size())；返回写入的字符数
+        std::size_t update(std::span<const std::uint8_t> in, std::span<char> out) {
+            if (out.size() < max_update_size(in.size()))
+                throw std::length_error("SimpleBase64::stream_encoder: output buffer too small");
+
+            std::size_t written = 0;
+            std::size_t i       = 0;
+            // 先补齐上一块留下的不足 3 字节
+            if (pending_ > 0) {
+                while (pending_ < 3 && i < in.size())
+                    carry_[pending_++] = in[i++];
+                if (pending_ < 3)
+                    return 0;
+                detail::encode_scalar(carry_, 3, out.data());
+                written  = 4;
+                pending_ = 0;
+            }
+
+            const std::size_t whole = (in.size() - i) / 3 * 3;
+            encode_to(out.data() + written, in.data() + i, whole);
+            written += whole / 3 * 4;
+            i += whole;
+
+            while (i < in.size())
+                carry_[pending_++] = in[i++];
+            return written;
+        }
+
+        // 输出剩余字节及填充，out 至少 4 个字符；返回写入的字符数
+        std::size_t finish(std::span<char> out) {
+            if (pending_ == 0)
+                return 0;
+            if (out.size() < 4)
+                throw std::length_error("SimpleBase64::stream_encoder: output buffer too small");
+            detail::encode_scalar(carry_, pending_, out.data());
+            pending_ = 0;
+            return 4;
+        }
+
+    private:
+        std::uint8_t carry_[3]{};
+        std::size_t pending_ = 0;
+    };
+
+    // 流式解码：按块输入任意切分的 Base64 文本，规则与 decode 相同（跳过非法字符，遇到 '=' 结束）
+    class stream_decoder {
+    public:
+        // update 一次最多写出的字节数（包括上一块留下的未满 8 位）
+        static constexpr std::size_t max_update_size(std::size_t len) { return max_decoded_size(len) + 6; }
+
+        // 解码一块文本，out 不小于 max_update_size(in.size())；返回写入的字节数
+        std::size_t update(std::string_view in, std::span<std::uint8_t> out) {
+            if (out.size() < max_update_size(in.size()))
+                throw std::length_error("SimpleBase64::stream_decoder: output buffer too small");
+
+            std::uint8_t* dst = out.data();
+            std::size_t i     = 0;
+            // 逐字符推进到 4 字符组的边界，之后才能交给向量实现
+            while (i < in.size() && !state_.done && state_.valb != -8)
+                dst += detail::decode_scalar(state_, in.data() + i++, 1, dst);
+            if (state_.done)
+                return static_cast<std::size_t>(dst - out.data());
+
+            const std::size_t blocks = detail::decode_blocks(in.data() + i, in.size() - i, dst, active_isa());
+            dst += blocks / 4 * 3;
+            i += blocks;
+            dst += detail::decode_scalar(state_, in.data() + i, in.size() - i, dst);
+            return static_cast<std::size_t>(dst - out.data());
+        }
+
+        // 是否已遇到 '='，之后的输入都会被忽略
+        [[nodiscard]] bool finished() const noexcept { return state_.done; }
+
+    private:
+        detail::decode_state state_;
+    };
+
+    // 编码，结果追加到 out 末尾；CharT 可以是 wchar_t，直接生成 ZXing 需要的宽字符串，省去一次转换拷贝
+    template <typename CharT>
+    inline void encode_append(std::basic_string<CharT>& out, const std::uint8_t* data, std::size_t len) {
+        const std::size_t start = out.size();
+        out.resize(start + encoded_size(len));
+        if constexpr (std::is_same_v<CharT, char>) {
+            encode_to(out.data() + start, data, len);
+        } else {
+            // 分段编码到栈上缓冲区再拓宽，不做额外的堆分配
+            constexpr std::size_t chunk = 3072;
+            char buffer[stream_encoder::max_update_size(chunk)];
+            stream_encoder encoder;
+            CharT* dst = out.data() + start;
+            for (std::size_t i = 0; i < len; i += chunk) {
+                const std::size_t n = std::min(chunk, len - i);
+                dst = std::copy_n(buffer, encoder.update({data + i, n}, buffer), dst);
+            }
+            std::copy_n(buffer, encoder.finish(buffer), dst);
+        }
+    }
+
     // 编码
-    inline std::string encode(const std::uint8_t* data, std::size_t len) {
-        std::string ret;
-        ret.reserve((len + 2) / 3 * 4);
-        int val = 0, valb = -6;
-        for (std::size_t i = 0; i < len; ++i) {
-            val = (val << 8) + data[i];
-            valb += 8;
-            while (valb >= 0) {
-                ret.push_back(base64_chars[(val >> valb) & 0x3F]);
-                valb -= 6;
-            }
-        }
-        if (valb > -6)
-            ret.push_back(base64_chars[((val << 8) >> (valb + 8)) & 0x3F]);
-        while (ret.size() % 4)
-            ret.push_back('=');
+    template <typename CharT = char>
+    inline std::basic_string<CharT> encode(const std::uint8_t* data, std::size_t len) {
+        std::basic_string<CharT> ret;
+        encode_append(ret, data, len);
         return ret;
     }
 
+    inline std::string encode(std::span<const std::uint8_t> data) { return encode(data.data(), data.size()); }
+
     inline std::string encode(const std::vector<std::uint8_t>& data) { return encode(data.data(), data.size()); }
 
     // 解码
-    inline std::vector<std::uint8_t> decode(const std::string& str) {
-        std::vector<std::uint8_t> ret;
-        std::vector<int> T(256, -1);
-        for (int i = 0; i < 64; i++)
-            T[static_cast<unsigned char>(base64_chars[i])] = i;
-
-        int val = 0, valb = -8;
-        for (unsigned char c : str) {
-            if (T[c] == -1) {
-                if (c == '=')
-                    break; // padding
-                else
-                    continue; // skip invalid chars
-            }
-            val = (val << 6) + T[c];
-            valb += 6;
-            if (valb >= 0) {
-                ret.push_back(std::uint8_t((val >> valb) & 0xFF));
-                valb -= 8;
-            }
-        }
+    inline std::vector<std::uint8_t> decode(std::string_view str) {
+        std::vector<std::uint8_t> ret(max_decoded_size(str.size()));
+        ret.resize(decode_to(ret.data(), str.data(), str.size()));
         return ret;
     }
 
@@ -9,6 +9,7 @@
 #include <QLabel>
 #include <QPainter>
 #include <QLineEdit>
+#include <QListView>
 #include <QMenu>
 #include <QMenuBar>
 #include <QMessageBox>
@@ -16,6 +17,7 @@
 #include <QProgressBar>
 #include <QPushButton>
 #include <QScrollArea>
+#include <QSet>
 #include <QtConcurrent>
 #include <SimpleBase64.h>
 #include <ZXing/BarcodeFormat.h>
@@ -24,32 +26,15 @@
 #include <spdlog/spdlog.h>
 #include "about_dialog.h"
 #include <ranges>
+#include <utility>
 #include "convert.h"
 #include "version_info/version.h"
 #include <magic_enum/magic_enum.hpp>
 #include "components/message_dialog.h"
-template <typename Ret, typename... Fs>
-    requires(std::is_void_v<Ret> || std::is_default_constructible_v<Ret>)
-struct overload_def_noop : private Fs... {
-    template <typename V, typename... Args>
-    constexpr explicit(false) overload_def_noop(std::in_place_type_t<V>, Args&&... fs) :
-        Fs{std::forward<Args>(fs)}... {}
-
-    using Fs::operator()...;
-
-    template <typename... T>
-        requires(!std::invocable<Fs, T...> && ...)
-    Ret operator()(T&&...) const noexcept {
-        if constexpr (std::is_void_v<Ret>) {
-            return;
-        } else {
-            return Ret{};
-        }
-    }
-};
-
-template <typename V, typename... Fs>
-overload_def_noop(std::in_place_type_t<V>, Fs&&...) -> overload_def_noop<V, std::decay_t<Fs>...>;
+#include "overload.h"
+#include "file_walker.h"
+#include "workers.h"
+#include "ResultListModel.h"
 
 void drawIcon(QPainter& p, bool isImage, bool isText){
     if(isImage) {
@@ -130,24 +115,100 @@ BarcodeWidget::BarcodeWidget(QWidget* parent) : QWidget(parent) {
     aboutAction = new QAction("关于软件", this);
     debugMqttAction = new QAction("MQTT实时消息监控窗口", this);
     openCameraScanAction = new QAction("打开摄像头扫码", this);
+    stageTimingsAction = new QAction("上次批处理耗时", this);
+    stageTimingsAction->setEnabled(false); // 第一批处理结束后才有数据
     // base64勾选，默认勾选
     base64CheckAcion = new QAction("Base64", this);
     base64CheckAcion->setCheckable(true);
     base64CheckAcion->setChecked(true); // 默认勾选
 
+    // 自动模式下 QR 系列用 Base45 走字母数字模式，比 Base64 走字节模式每字节少约 2.4 位；解码按标记自动识别
+    textPackingMenu  = new QMenu("文本编码", this);
+    textPackingGroup = new QActionGroup(this);
+    for (const auto& [text, packing] : {std::pair{"自动", convert::text_packing::automatic},
+             std::pair{"Base64", convert::text_packing::base64}, std::pair{"Base45", convert::text_packing::base45}}) {
+        auto* action = textPackingMenu->addAction(text);
+        action->setCheckable(true);
+        action->setData(static_cast<int>(packing));
+        action->setChecked(packing == convert::text_packing::automatic); // 默认自动
+        textPackingGroup->addAction(action);
+    }
+
+    // 原始字节直接写入条码的字节模式，比 Base64 少三分之一的体积；勾选后 Base64 不再生效
+    binaryAction = new QAction("原始字节", this);
+    binaryAction->setCheckable(true);
+    binaryAction->setChecked(false); // 默认不勾选
+
+    // 压缩结果是二进制数据，只能跟随 Base64 或原始字节一起使用；压缩后不变小时自动跳过
+    compressAction = new QAction("压缩", this);
+    compressAction->setCheckable(true);
+    compressAction->setChecked(true); // 默认勾选
+
     directTextAction = new QAction("文本输入", this);
     directTextAction->setCheckable(true);
     directTextAction->setChecked(false); // 默认不勾选
 
+    // 解码时按所选格式和识别强度配置 ZXing，未勾选“仅识别所选格式”时识别失败会再尝试全部格式
+    decodeEffortMenu  = new QMenu("识别强度", this);
+    decodeEffortGroup = new QActionGroup(this);
+    for (const auto& [text, effort] : {std::pair{"快速", convert::decode_effort::fast},
+             std::pair{"均衡", convert::decode_effort::balanced}, std::pair{"全面", convert::decode_effort::thorough}}) {
+        auto* action = decodeEffortMenu->addAction(text);
+        action->setCheckable(true);
+        action->setData(static_cast<int>(effort));
+        action->setChecked(effort == convert::decode_effort::balanced); // 默认均衡，识别失败时以全面强度再试一次
+        decodeEffortGroup->addAction(action);
+    }
+
+    strictFormatAction = new QAction("仅识别所选格式", this);
+    strictFormatAction->setCheckable(true);
+    strictFormatAction->setChecked(false); // 默认不勾选
+
+    // 一张图片里有多个条码（如整页标签）时逐个识别，大图分块并行
+    sheetDecodeAction = new QAction("整页多码识别", this);
+    sheetDecodeAction->setCheckable(true);
+    sheetDecodeAction->setChecked(false); // 默认不勾选
+
+    // 生成的条码只有黑白两色，默认保存为 1 位 PNG，像素与 8 位 PNG 相同，文件更小、写入更快
+    saveOptions     = convert::image_save_options::loadOutputConfig("./setting/config.json");
+    imageFormatMenu  = new QMenu("图片格式", this);
+    imageFormatGroup = new QActionGroup(this);
+    for (const auto& [text, format] : {std::pair{"PNG（8 位灰度）", convert::image_format::png},
+             std::pair{"PNG（1 位）", convert::image_format::png_1bit}, std::pair{"PBM", convert::image_format::pbm},
+             std::pair{"模块矩阵（PBM）", convert::image_format::modules}}) {
+        auto* action = imageFormatMenu->addAction(text);
+        action->setCheckable(true);
+        action->setData(static_cast<int>(format));
+        action->setChecked(format == saveOptions.format);
+        imageFormatGroup->addAction(action);
+    }
+
+    // 大批量生成时每张图片写盘后即释放，界面只保留缩略图，内存占用与批次大小无关
+    streamSaveAction = new QAction("生成后直接保存", this);
+    streamSaveAction->setCheckable(true);
+    streamSaveAction->setChecked(false); // 默认不勾选
+
     helpMenu->addAction(aboutAction);
     toolsMenu->addAction(debugMqttAction);
     toolsMenu->addAction(openCameraScanAction);
+    toolsMenu->addAction(stageTimingsAction);
     settingMenu->addAction(base64CheckAcion);
+    settingMenu->addMenu(textPackingMenu);
+    settingMenu->addAction(binaryAction);
+    settingMenu->addAction(compressAction);
     settingMenu->addAction(directTextAction);
+    settingMenu->addSeparator();
+    settingMenu->addMenu(decodeEffortMenu);
+    settingMenu->addAction(strictFormatAction);
+    settingMenu->addAction(sheetDecodeAction);
+    settingMenu->addSeparator();
+    settingMenu->addMenu(imageFormatMenu);
+    settingMenu->addAction(streamSaveAction);
 
     // 连接菜单项的点击信号
     connect(aboutAction, &QAction::triggered, this, &BarcodeWidget::showAbout);
     connect(debugMqttAction, &QAction::triggered, this, &BarcodeWidget::showMqttDebugMonitor);
+    connect(stageTimingsAction, &QAction::triggered, this, &BarcodeWidget::showStageTimings);
     connect(openCameraScanAction, &QAction::triggered, this,[this] {
         spdlog::info("BarcodeWidget openCameraScanAction triggered");
         preview.startCamera();
@@ -162,7 +223,7 @@ BarcodeWidget::BarcodeWidget(QWidget* parent) : QWidget(parent) {
 
     auto* fileLayout = new QHBoxLayout();
     filePathEdit     = new QLineEdit(this);
-    filePathEdit->setPlaceholderText("选择一个文件或图片");
+    filePathEdit->setPlaceholderText("选择文件、图片或目录，也可输入通配符，如 D:/data/**/*.txt");
     filePathEdit->setFont(Ui::getAppFont(14));
     filePathEdit->setStyleSheet(
         "QLineEdit { border: 1px solid #ccc; border-radius: 5px; padding: 5px; background-color: #f9f9f9; }");
@@ -173,8 +234,16 @@ BarcodeWidget::BarcodeWidget(QWidget* parent) : QWidget(parent) {
     browseButton->setStyleSheet(
         "QPushButton { background-color: #4CAF50; color: white; border-radius: 5px; padding: 10px; }"
         "QPushButton:disabled { background-color: #ddd; }");
+    // 整个目录树交给后台线程递归枚举，不在文本框中展开
+    QPushButton* browseDirButton = new QPushButton("目录", this);
+    browseDirButton->setFixedWidth(100);
+    browseDirButton->setFont(Ui::getAppFont(16));
+    browseDirButton->setStyleSheet(
+        "QPushButton { background-color: #4CAF50; color: white; border-radius: 5px; padding: 10px; }"
+        "QPushButton:disabled { background-color: #ddd; }");
     fileLayout->addWidget(filePathEdit);
     fileLayout->addWidget(browseButton);
+    fileLayout->addWidget(browseDirButton);
     mainLayout->addLayout(fileLayout);
 
     // 生成与保存按钮
@@ -199,6 +268,13 @@ BarcodeWidget::BarcodeWidget(QWidget* parent) : QWidget(parent) {
     buttonLayout->addWidget(generateButton);
     buttonLayout->addWidget(decodeToChemFile);
     buttonLayout->addWidget(saveButton);
+
+    // 批处理进行中才显示；取消后尚未开始的任务不再执行，已完成的结果照常显示
+    cancelButton = new QPushButton("取消", this);
+    cancelButton->setFixedHeight(40);
+    cancelButton->setFont(Ui::getAppFont(16));
+    cancelButton->setVisible(false);
+    buttonLayout->addWidget(cancelButton);
     mainLayout->addLayout(buttonLayout);
 
 
@@ -220,6 +296,7 @@ BarcodeWidget::BarcodeWidget(QWidget* parent) : QWidget(parent) {
     scrollArea->setMinimumHeight(320);
     scrollArea->setStyleSheet("QScrollArea { background-color: #f0f0f0; border: 1px solid #ccc; }");
     mainLayout->addWidget(scrollArea);
+    resultModel = new ResultListModel(lastResults, this);
 
     auto* comboBoxLayout      = new QHBoxLayout();
 
@@ -273,10 +350,22 @@ BarcodeWidget::BarcodeWidget(QWidget* parent) : QWidget(parent) {
 
     messageWidget = std::make_unique<MQTTMessageWidget>();
 
+    barcodeCache = std::make_unique<convert::barcode_cache>(convert::barcode_cache::loadCacheConfig("./setting/config.json"));
+    pipelineConfig = workers::pipeline_config::loadPipelineConfig("./setting/config.json");
+    batchPools     = std::make_unique<workers::batch_pools>(pipelineConfig);
+
     connect(browseButton, &QPushButton::clicked, this, &BarcodeWidget::onBrowseFile);
+    connect(browseDirButton, &QPushButton::clicked, this, &BarcodeWidget::onBrowseDirectory);
     connect(generateButton, &QPushButton::clicked, this, &BarcodeWidget::onGenerateClicked);
     connect(decodeToChemFile, &QPushButton::clicked, this, &BarcodeWidget::onDecodeToChemFileClicked);
     connect(saveButton, &QPushButton::clicked, this, &BarcodeWidget::onSaveClicked);
+    connect(cancelButton, &QPushButton::clicked, this, [this] {
+        if (runningBatch) {
+            cancelBatch();
+            batchCanceled = true;
+            cancelButton->setEnabled(false);
+        }
+    });
     connect(filePathEdit, &QLineEdit::textChanged, this, [this](const QString& text) {
         lastResults.clear();
         lastSelectedFiles = text.split(QDir::listSeparator());
@@ -336,7 +425,15 @@ BarcodeWidget::BarcodeWidget(QWidget* parent) : QWidget(parent) {
                 messageWidget->addMessage(topic, payload);
     });
 
-    connect(directTextAction, &QAction::toggled, this, [this, browseButton](bool checked) {
+    const auto updatePayloadActions = [this] {
+        base64CheckAcion->setEnabled(!binaryAction->isChecked());
+        textPackingMenu->setEnabled(base64CheckAcion->isChecked() && !binaryAction->isChecked());
+        compressAction->setEnabled(base64CheckAcion->isChecked() || binaryAction->isChecked());
+    };
+    connect(base64CheckAcion, &QAction::toggled, this, updatePayloadActions);
+    connect(binaryAction, &QAction::toggled, this, updatePayloadActions);
+
+    connect(directTextAction, &QAction::toggled, this, [this, browseButton, browseDirButton](bool checked) {
         filePathEdit->clear();
         lastSelectedFiles.clear();
         lastResults.clear();
@@ -344,9 +441,11 @@ BarcodeWidget::BarcodeWidget(QWidget* parent) : QWidget(parent) {
         if(checked) {
             filePathEdit->setPlaceholderText("输入要转换的文字");
             browseButton->setEnabled(false);
+            browseDirButton->setEnabled(false);
         }else {
-            filePathEdit->setPlaceholderText("选择一个文件或图片");
+            filePathEdit->setPlaceholderText("选择文件、图片或目录，也可输入通配符，如 D:/data/**/*.txt");
             browseButton->setEnabled(true);
+            browseDirButton->setEnabled(true);
             decodeToChemFile->setEnabled(false);
         }
 
@@ -366,6 +465,13 @@ BarcodeWidget::BarcodeWidget(QWidget* parent) : QWidget(parent) {
     renderResults();
 }
 
+BarcodeWidget::~BarcodeWidget() {
+    if (runningBatch) {
+        // 窗口关闭时不再需要结果，在途的项也一并跳过
+        cancelBatch();
+        runningBatch->cancel();
+    }
+}
 
 void BarcodeWidget::updateButtonStates() const {
     saveButton->setEnabled(false);
@@ -374,7 +480,7 @@ void BarcodeWidget::updateButtonStates() const {
         generateButton->setEnabled(false);
         decodeToChemFile->setEnabled(false);
     }else {
-        if(lastSelectedFiles.size() == 1) {
+        if(lastSelectedFiles.size() == 1 && !workers::walk_spec::is_walk_input(lastSelectedFiles.front())) {
             auto& file = lastSelectedFiles.front();
 
             bool isImage = fileExtensionRegex_image.match(file).hasMatch();
@@ -395,11 +501,25 @@ void BarcodeWidget::onBrowseFile() const {
     fileDialog->open();
 }
 
+void BarcodeWidget::onBrowseDirectory() {
+    const QString dir = QFileDialog::getExistingDirectory(this, "选择需要批量处理的目录",
+        QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation),
+        QFileDialog::ShowDirsOnly | QFileDialog::DontResolveSymlinks);
+    if (!dir.isEmpty()) {
+        // 文本框的 textChanged 会更新 lastSelectedFiles
+        filePathEdit->setText(QDir::toNativeSeparators(dir));
+    }
+}
+
 void BarcodeWidget::onGenerateClicked() {
     const auto reqWidth  = widthInput->text().toInt();
     const auto reqHeight = heightInput->text().toInt();
     const auto useBase64 = base64CheckAcion->isChecked();
+    const auto compress  = compressAction->isChecked();
+    const auto packing   = static_cast<convert::text_packing>(textPackingGroup->checkedAction()->data().toInt());
     const auto format    = currentBarcodeFormat;
+    // 不支持字节模式的格式忽略原始字节选项，按 Base64 设置生成，分片规划与生成保持一致
+    const auto binary    = binaryAction->isChecked() && convert::supports_binary(format);
 
     if (directTextAction->isChecked()) {
         QString rawText = filePathEdit->text();
@@ -410,235 +530,225 @@ void BarcodeWidget::onGenerateClicked() {
         QStringList inputs;
         inputs.append(rawText);
 
-        // 准备 UI
-        progressBar->setVisible(true);
-        progressBar->setRange(0, 1);
-        progressBar->setValue(0);
-        generateButton->setEnabled(false);
-        saveButton->setEnabled(false);
-        this->setCursor(Qt::WaitCursor);
-
-        // 定义处理文本的 Worker
-        struct TextWorker {
-            using result_type = convert::result_data_entry;
-
-            bool useBase64;
-            convert::QRcode_create_config config;
-
-            convert::result_data_entry operator()(const QString& textInput) const {
-                convert::result_data_entry res;
-                // 对于直接文本模式，source_file_name 可以设为空，或者设为一个标识字符串
-                // 这样在保存文件时，会默认生成 "qrcode.png" 之类的名字
-                res.source_file_name = "raw_text_input";
-
-                try {
-                    std::string content;
-                    if (useBase64) {
-                        // 如果勾选了 Base64，先将输入文本转为 UTF-8 字节流，再 Base64 编码
-                        QByteArray data = textInput.toUtf8();
-                        content = SimpleBase64::encode(reinterpret_cast<const std::uint8_t*>(data.constData()), data.size());
-                    } else {
-                        content = textInput.toStdString();
-                    }
-
-                    auto img = convert::byte_to_QRCode_qimage(
-                        content, config);
-
-                    if (!img.isNull()) {
-                        res.data = img;
-                    } else {
-                        res.data = std::string("生成图片失败");
-                    }
-                } catch (const std::exception& e) {
-                    res.data.emplace<std::string>(e.what());
-                }
-                return res;
-            }
-        };
-
         auto* watcher = new QFutureWatcher<convert::result_data_entry>(this);
+        connect(watcher, &QFutureWatcher<convert::result_data_entry>::resultsReadyAt, this,
+            [this, watcher](int begin, int end) { onResultsReady(*watcher, begin, end); });
         connect(watcher, &QFutureWatcher<convert::result_data_entry>::finished,
-            [this, watcher] { onBatchFinish(*watcher); });
+            [this, watcher] {
+                onBatchFinish(*watcher);
+                barcodeCache->logStats();
+            });
 
-        // 启动异步任务
-        watcher->setFuture(QtConcurrent::mapped(inputs, TextWorker{useBase64, {reqWidth, reqHeight, format}}));
+        // 准备 UI，启动异步任务
+        beginBatch(watcher, 1, true);
+        watcher->setFuture(QtConcurrent::mapped(inputs,
+            workers::generate_text_worker{useBase64, {reqWidth, reqHeight, format}, barcodeCache.get(), compress, binary, packing,
+                ResultListModel::thumbnailSize}));
 
         return; // 结束函数，不再执行下方的文件处理逻辑
     }
 
+    // 目录和通配符在后台线程中边枚举边生成，不预先展开
+    const bool walk = std::ranges::any_of(lastSelectedFiles, &workers::walk_spec::is_walk_input);
+
     QStringList filePaths;
-    filePaths.reserve(static_cast<int>(lastResults.size()));
-
-    //因为先前的逻辑是不是图片就算文本，所以先这样吧
-    std::ranges::copy(lastSelectedFiles | std::views::filter([](const QString& file) {
-        return !fileExtensionRegex_image.match(file).hasMatch();
-    }), std::back_inserter(filePaths));
-    if (filePaths.empty()) {
-        QMessageBox::warning(this, "警告", "无可处理文件");
-        return;
+    if (!walk) {
+        filePaths.reserve(static_cast<int>(lastResults.size()));
+
+        //因为先前的逻辑是不是图片就算文本，所以先这样吧
+        std::ranges::copy(lastSelectedFiles | std::views::filter([](const QString& file) {
+            return !fileExtensionRegex_image.match(file).hasMatch();
+        }), std::back_inserter(filePaths));
+        if (filePaths.empty()) {
+            QMessageBox::warning(this, "警告", "无可处理文件");
+            return;
+        }
+    }
+    QString outputDir;
+    if (streamSaveAction->isChecked()) {
+        outputDir = QFileDialog::getExistingDirectory(this, "请选择保存文件夹",
+            QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation),
+            QFileDialog::ShowDirsOnly | QFileDialog::DontResolveSymlinks);
+        if (outputDir.isEmpty())
+            return;
     }
-    // 2. UI 状态准备
-    progressBar->setVisible(true);
-    progressBar->setRange(0, filePaths.size()); // 设置进度条范围
-    progressBar->setValue(0);
-    generateButton->setEnabled(false);
-    decodeToChemFile->setEnabled(false);
-    saveButton->setEnabled(false);
-    this->setCursor(Qt::WaitCursor);
-
-    struct worker {
-        using result_type = convert::result_data_entry;
-        int reqWidth;
-        int reqHeight;
-        bool useBase64;
-        ZXing::BarcodeFormat format;
-
-        convert::result_data_entry operator()(const QString& filePath) const {
-            try {
-                QFile file(filePath);
-
-                convert::result_data_entry res;
-                if (!file.open(QIODevice::ReadOnly)) {
-                    res.data = std::string("无法打开文件: ") + filePath.toStdString();
-                    res.source_file_name = std::move(filePath);
-                    return res;
-                } else {
-                    res.source_file_name = std::move(filePath);
-                }
-
-                const QByteArray data = file.readAll();
-                file.close();
-
-                // 是否base64处理通过判断base64CheckBox
-                std::string text;
-                if (useBase64) {
-                    text = SimpleBase64::encode(reinterpret_cast<const std::uint8_t*>(data.constData()), data.size());
-                } else {
-                    text = data.toStdString();
-                }
-
-                auto img = convert::byte_to_QRCode_qimage(
-                    text, {.target_width = reqWidth, .target_height = reqHeight, .format = format, .margin = 1});
 
-                if (!img.isNull()) {
-                    res.data = img;
-                } else {
-                    res.data = std::string("生成图片失败");
-                }
+    auto options   = saveOptions;
+    options.format = static_cast<convert::image_format>(imageFormatGroup->checkedAction()->data().toInt());
+
+    // 直接保存时在输出目录中记录续跑日志，中断后以相同参数重新生成可以跳过已经写出的文件
+    std::shared_ptr<workers::batch_journal> journal;
+    const auto skipped = std::make_shared<std::atomic<int>>(0);
+    if (!outputDir.isEmpty()) {
+        const std::string settings = QString("generate;format=%1;size=%2x%3;base64=%4;compress=%5;binary=%6;packing=%7;image=%8;level=%9")
+                                         .arg(static_cast<int>(format)).arg(reqWidth).arg(reqHeight)
+                                         .arg(useBase64).arg(compress).arg(binary).arg(static_cast<int>(packing))
+                                         .arg(static_cast<int>(options.format)).arg(options.png_level)
+                                         .toStdString();
+        journal = std::make_shared<workers::batch_journal>();
+        if (!journal->open(QDir(outputDir).filePath(workers::batch_journal::default_name), settings)) {
+            journal.reset();
+        } else if (const auto done = journal->completed_count(); done > 0) {
+            const auto answer = QMessageBox::question(this, "继续上次的批次",
+                QString("输出目录中记录了上次以相同参数完成的 %1 项。\n是否跳过已完成的文件继续？选择“否”将全部重新生成。").arg(done));
+            if (answer != QMessageBox::Yes) {
+                journal->reset();
+            }
+        }
+    }
 
-                return res;
-            } catch (const std::exception& e) {
-                convert::result_data_entry res;
-                res.source_file_name = std::move(filePath);
-                res.data.emplace<std::string>(e.what());
-                return res;
+    // 超出单个条码容量的文件拆成多个分片，每个分片作为独立任务并行生成；日志中已完成的分片跳过
+    // 目录输入记下相对于枚举根目录的子目录，保存时在输出目录中保持层级
+    const auto planParts = [=, imageRegex = fileExtensionRegex_image](const QString& path, const QString& relativeDir = {}) {
+        if (imageRegex.match(path).hasMatch()) {
+            return QList<workers::file_part>{};
+        }
+        auto planned = workers::plan_file_parts(path, format, useBase64, binary, packing);
+        if (journal) {
+            planned = workers::journal_pending(*journal, planned);
+            if (planned.isEmpty()) {
+                ++*skipped;
+                return planned;
             }
         }
+        for (auto& part : planned) {
+            part.relativeDir = relativeDir;
+        }
+        return planned;
     };
+    // 规划要核对续跑日志、为拆分的文件计算分组 id，可能读遍整个文件，明确列出的文件也放到生产者线程中边规划边生成
+    const auto parts = workers::walk_into_queue(*batchPools, walk ? lastSelectedFiles : filePaths, planParts);
+
+    // 内容相同的整文件只编码一次，结果按各自的文件名分发；直接保存时从第一个写出的文件复制，内存中不保留图片
+    const bool dedup = pipelineConfig.dedup_entries > 0;
+    const auto dedupCapacity = static_cast<std::size_t>(pipelineConfig.dedup_entries);
+    workers::generate_file_worker generate{reqWidth, reqHeight, useBase64, format, barcodeCache.get(), compress, binary, packing};
+    workers::generate_save_worker generateSave{{}, workers::encode_worker{options}, outputDir};
+    std::shared_ptr<workers::dedup_counter> dedupCounter;
+    if (dedup && outputDir.isEmpty()) {
+        generate.dedup = std::make_shared<workers::batch_dedup<convert::result_data_entry>>(dedupCapacity);
+        dedupCounter   = generate.dedup;
+    } else if (dedup) {
+        generateSave.dedup = std::make_shared<workers::batch_dedup<workers::pending_save>>(dedupCapacity);
+        dedupCounter       = generateSave.dedup;
+    }
 
     auto* watcher = new QFutureWatcher<convert::result_data_entry>(this);
 
-    connect(watcher, &QFutureWatcher<convert::result_data_entry>::progressValueChanged, progressBar, &QProgressBar::setValue);
+    // 每完成一条就显示一条，不必等整批结束
+    connect(watcher, &QFutureWatcher<convert::result_data_entry>::resultsReadyAt, this,
+        [this, watcher](int begin, int end) { onResultsReady(*watcher, begin, end); });
 
     connect(watcher, &QFutureWatcher<convert::result_data_entry>::finished,
-        [this, watcher] {
+        [this, watcher, outputDir, skipped, dedupCounter] {
             onBatchFinish(*watcher);
+            barcodeCache->logStats();
+            if (dedupCounter)
+                dedupCounter->logStats();
+            if (!outputDir.isEmpty())
+                reportStreamSave(outputDir, skipped->load(), dedupCounter ? dedupCounter->stats() : workers::dedup_stats{});
         }
     );
 
-    watcher->setFuture(QtConcurrent::mapped(filePaths, worker{reqWidth, reqHeight, useBase64, format}));
+    // 2. UI 状态准备
+    beginBatch(watcher, parts->pushed(), true, [parts] { parts->cancel(); });
+
+    // 分片在 I/O 池中读入内存并顺带计算摘要，编码在 CPU 池中进行
+    const workers::load_part_worker load{useBase64, binary, dedup || journal != nullptr};
+    if (outputDir.isEmpty()) {
+        // 缩略图在工作线程中随结果一起生成
+        generate.thumbnailSize = ResultListModel::thumbnailSize;
+        watcher->setFuture(workers::run_pipeline(*batchPools, parts, load, generate));
+        return;
+    }
+
+    // 缩略图最多保留 maxStreamThumbnails 张（1 位 200x200，约 5KB 一张），其余结果只记录保存路径
+    static constexpr int maxStreamThumbnails = 512;
+    generateSave.generate   = generate;
+    generateSave.thumbnails = std::make_shared<std::atomic<int>>(maxStreamThumbnails);
+    generateSave.journal    = journal;
+    // 生成并编码后交回 I/O 池写盘
+    watcher->setFuture(workers::run_pipeline(*batchPools, parts, load, generateSave, generateSave));
 }
 
 void BarcodeWidget::onDecodeToChemFileClicked() {
 
-    const QStringList filePaths = lastSelectedFiles.filter(fileExtensionRegex_image);
-    if (filePaths.empty()) {
-        QMessageBox::warning(this, "警告", "无可处理文件");
-        return;
+    // 目录和通配符在后台线程中边枚举边识别，只取其中的图片
+    std::shared_ptr<workers::input_queue<QString>> filePaths;
+    if (std::ranges::any_of(lastSelectedFiles, &workers::walk_spec::is_walk_input)) {
+        filePaths = workers::walk_into_queue(*batchPools, lastSelectedFiles, [imageRegex = fileExtensionRegex_image](const QString& path, const QString&) {
+            return imageRegex.match(path).hasMatch() ? QList<QString>{path} : QList<QString>{};
+        });
+    } else {
+        const QStringList images = lastSelectedFiles.filter(fileExtensionRegex_image);
+        if (images.empty()) {
+            QMessageBox::warning(this, "警告", "无可处理文件");
+            return;
+        }
+        filePaths = workers::input_queue<QString>::from_list(images);
     }
 
-    // 2. UI 状态准备
-    progressBar->setVisible(true);
-    progressBar->setRange(0, filePaths.size()); // 设置进度条范围
-    progressBar->setValue(0);
-    generateButton->setEnabled(false);
-    decodeToChemFile->setEnabled(false);
-    saveButton->setEnabled(false);
-    this->setCursor(Qt::WaitCursor);
-
-    struct worker {
-        using result_type = convert::result_data_entry;
-
-        bool useBase64;
-        convert::result_data_entry operator()(QString path) const {
-            try {
-                const auto file_path = path.toLocal8Bit().toStdString();
-                switch (auto rst = convert::QRcode_to_byte(file_path); rst.err) {
-                case convert::result_i2t::empty_img:
-                    spdlog::error("cv::imread 无法加载图片文件: {}", path.toStdString());
-                    return {std::move(path), QString{"无法加载图片文件: %1"}.arg(path).toStdString()};
-                case convert::result_i2t::invalid_qrcode:
-                    return {std::move(path), std::string{"无法识别条码或条码格式不正确"}};
-                default:
-                    std::vector<std::uint8_t> decodedData;
-                    if (useBase64) {
-                        decodedData = SimpleBase64::decode(rst.text);
-                    } else {
-                        decodedData = std::vector<std::uint8_t>(rst.text.begin(), rst.text.end());
-                    }
-                    return {std::move(path),
-                        QByteArray(reinterpret_cast<const char*>(decodedData.data()), static_cast<int>(decodedData.size()))};
-                }
-            } catch (const std::exception& e) {
-                return {std::move(path), QString("解码失败:\n%1").arg(e.what()).toStdString()};
-            }
-        }
+    // 格式选 None 时不限定格式
+    const convert::decode_profile profile{
+        .formats              = currentBarcodeFormat,
+        .effort               = static_cast<convert::decode_effort>(decodeEffortGroup->checkedAction()->data().toInt()),
+        .fallback_all_formats = !strictFormatAction->isChecked(),
     };
 
+    if (sheetDecodeAction->isChecked()) {
+        // 整页识别时一张图片产生多条结果
+        using sheet_results = workers::decode_sheet_worker::result_type;
+        auto* watcher = new QFutureWatcher<sheet_results>(this);
+
+        connect(watcher, &QFutureWatcher<sheet_results>::resultsReadyAt, this,
+            [this, watcher](int begin, int end) { onResultsReady(*watcher, begin, end); });
+
+        connect(watcher, &QFutureWatcher<sheet_results>::finished, [this, watcher] { onBatchFinish(*watcher); });
+
+        beginBatch(watcher, filePaths->pushed(), true, [filePaths] { filePaths->cancel(); });
+        watcher->setFuture(workers::run_pipeline(*batchPools, filePaths, workers::load_file_worker{},
+            workers::decode_sheet_worker{base64CheckAcion->isChecked(), profile}));
+        return;
+    }
+
     auto* watcher = new QFutureWatcher<convert::result_data_entry>(this);
 
-    connect(watcher, &QFutureWatcher<convert::result_data_entry>::progressValueChanged,
-        progressBar, &QProgressBar::setValue);
+    connect(watcher, &QFutureWatcher<convert::result_data_entry>::resultsReadyAt, this,
+        [this, watcher](int begin, int end) { onResultsReady(*watcher, begin, end); });
 
     connect(watcher, &QFutureWatcher<convert::result_data_entry>::finished,
         [this, watcher] { onBatchFinish(*watcher); });
 
-    watcher->setFuture(QtConcurrent::mapped(filePaths, worker{base64CheckAcion->isChecked()}));
+    // 2. UI 状态准备
+    beginBatch(watcher, filePaths->pushed(), true, [filePaths] { filePaths->cancel(); });
+    // 图片在 I/O 池中读入内存，解码和识别在 CPU 池中进行
+    watcher->setFuture(workers::run_pipeline(*batchPools, filePaths, workers::load_file_worker{},
+        workers::decode_file_worker{base64CheckAcion->isChecked(), profile}));
 }
 
 void BarcodeWidget::onSaveClicked() {
-    if (lastResults.empty()) {
+    if (std::ranges::none_of(lastResults, [](const auto& entry) { return entry.saved_path.isEmpty(); })) {
         QMessageBox::warning(this, "警告", "没有可保存的内容。");
         return;
     }
 
-    struct SaveTask {
-        convert::result_data_entry entry;
-        QString                    dest;
-    };
-
-    struct SaveResult {
-        enum errcode {
-            success,
-            invalid_data,
-            failed,
-        };
-
-        errcode err;
-        QString path;
-    };
-
-    QList<SaveTask> tasks;
+    QList<workers::save_task> tasks;
+    auto options         = saveOptions;
+    options.format       = static_cast<convert::image_format>(imageFormatGroup->checkedAction()->data().toInt());
+    const QString suffix = options.suffix();
 
     if (lastResults.size() == 1) {
         const auto& entry = lastResults.front();
 
-        const QString defName   = entry.get_default_target_name();
+        const QString defName   = entry.get_default_target_name(suffix);
+        const auto saveImageName = [&] {
+            return QFileDialog::getSaveFileName(this, "保存图片", defName,
+                suffix == "png" ? "PNG Images (*.png)" : "PBM Images (*.pbm)");
+        };
         auto fileName  = std::visit<QString>(
             overload_def_noop{std::in_place_type<QString>,
-                [&](const QImage&) {
-                    return QFileDialog::getSaveFileName(this, "保存图片", defName, "PNG Images (*.png)");
-                },
+                [&](const QImage&) { return saveImageName(); },
+                [&](const convert::module_matrix&) { return saveImageName(); },
                 [&](const QByteArray&) {
                     return QFileDialog::getSaveFileName(
                         this, "保存文件", defName, "Binary Files (*.rfa);;Text Files (*.txt)");
@@ -656,13 +766,20 @@ void BarcodeWidget::onSaveClicked() {
         if (dir.isEmpty())
             return;
 
+        // 目录输入保持子目录层级；仍然重名的（如识别结果、扩展名不同的同名文件）依次加上 "_序号"
         const QDir outputDir(dir);
+        QSet<QString> used;
         for (const auto& entry : lastResults) {
-            if (!entry) {
+            if (!entry || !entry.saved_path.isEmpty()) {
                 continue;
             }
 
-            const QString fileName = outputDir.filePath(entry.get_default_target_name());
+            QString fileName = outputDir.filePath(entry.get_default_target_path(suffix));
+            const QFileInfo info(fileName);
+            for (int n = 2; used.contains(fileName); ++n) {
+                fileName = info.dir().filePath(QString("%1_%2.%3").arg(info.completeBaseName()).arg(n).arg(info.suffix()));
+            }
+            used.insert(fileName);
             tasks.append({entry, std::move(fileName)});
         }
     }
@@ -670,54 +787,10 @@ void BarcodeWidget::onSaveClicked() {
     if (tasks.isEmpty())
         return;
 
-    progressBar->setVisible(true);
-    progressBar->setRange(0, tasks.size());
-    progressBar->setValue(0);
-    saveButton->setEnabled(false);
-    generateButton->setEnabled(false);
-    decodeToChemFile->setEnabled(false);
-    this->setCursor(Qt::WaitCursor);
-
-    struct worker {
-        using result_type = SaveResult;
-        SaveResult operator()(const SaveTask& task) const noexcept try {
-            return std::visit<SaveResult>(
-                overload_def_noop{std::in_place_type<SaveResult>,
-                    [&](const QImage& img) -> SaveResult {
-                        if (img.isNull())
-                            return {SaveResult::invalid_data, task.dest};
-                        if (img.save(task.dest)) {
-                            return {SaveResult::success, task.dest};
-                        } else {
-                            return {SaveResult::failed, task.dest};
-                        }
-                    },
-                    [&](const QByteArray& data) -> SaveResult {
-                        if (data.isEmpty())
-                            return {SaveResult::invalid_data, task.dest};
-
-                        QFile f(task.dest);
-                        if (f.open(QIODevice::WriteOnly)) {
-                            f.write(data);
-                            f.close();
-                            return {SaveResult::success, task.dest};
-                        }
-                        return {SaveResult::failed, task.dest};
-                    },
-                    [&](const auto&) noexcept { return SaveResult{SaveResult::failed, task.dest}; }},
-                task.entry.data);
-        } catch (...) {
-            return {SaveResult::failed};
-        }
-    };
-
-    auto* watcher = new QFutureWatcher<SaveResult>(this);
-
-    connect(watcher, &QFutureWatcher<SaveResult>::progressValueChanged, progressBar, &QProgressBar::setValue);
+    auto* watcher = new QFutureWatcher<workers::save_result>(this);
 
-    connect(watcher, &QFutureWatcher<SaveResult>::finished, [this, watcher]() {
-        this->setCursor(Qt::ArrowCursor);
-        progressBar->setVisible(false);
+    connect(watcher, &QFutureWatcher<workers::save_result>::finished, [this, watcher]() {
+        endBatch();
 
         // 恢复按钮状态
         updateButtonStates();
@@ -733,7 +806,7 @@ void BarcodeWidget::onSaveClicked() {
         for (const auto& res : list) {
             QString fileName = QFileInfo(res.path).fileName();
 
-            if (res.err == SaveResult::success) {
+            if (res.err == workers::save_result::success) {
                 successCount++;
                 // 如果总数不多，记录成功的文件名用于展示
                 if (list.size() <= 10) {
@@ -742,10 +815,10 @@ void BarcodeWidget::onSaveClicked() {
             } else {
                 QString reason;
                 switch (res.err) {
-                case SaveResult::invalid_data:
+                case workers::save_result::invalid_data:
                     reason = "数据为空或无效";
                     break;
-                case SaveResult::failed:
+                case workers::save_result::failed:
                     reason = "写入失败";
                     break;
                 default:
@@ -772,19 +845,30 @@ void BarcodeWidget::onSaveClicked() {
             if (failedInfos.size() > maxErrorsToShow) {
                 msg += QString("...以及其他 %1 个文件").arg(failedInfos.size() - maxErrorsToShow);
             }
+            if (const QString timings = stageTimingText(); !timings.isEmpty()) {
+                msg += "\n\n" + timings;
+            }
             QMessageBox::warning(this, "保存结果 - 包含错误", msg);
         } else {
             // 全部成功的情况
             if (!successInfos.isEmpty() && list.size() > 1) {
                 msg += "\n\n[文件列表]:\n" + successInfos.join("\n");
             }
+            if (const QString timings = stageTimingText(); !timings.isEmpty()) {
+                msg += "\n\n" + timings;
+            }
             QMessageBox::information(this, "保存成功", msg);
         }
 
         watcher->deleteLater();
     });
 
-    watcher->setFuture(QtConcurrent::mapped(tasks, worker{}));
+    // 取消时已写出的文件照常计入汇总
+    auto queue = workers::input_queue<workers::save_task>::from_list(std::move(tasks));
+    beginBatch(watcher, queue->pushed(), false, [queue] { queue->cancel(); });
+    // 编码在 CPU 池中进行，写盘交给 I/O 池
+    watcher->setFuture(workers::run_pipeline(*batchPools, queue, workers::no_stage{}, workers::encode_worker{options},
+        workers::write_worker{}));
 }
 
 void BarcodeWidget::showAbout() const {
@@ -804,6 +888,35 @@ void BarcodeWidget::showMqttDebugMonitor() const {
     messageWidget->show();
 }
 
+void BarcodeWidget::showStageTimings() {
+    const QString text = stageTimingText();
+    QMessageBox::information(this, "上次批处理耗时", text.isEmpty() ? QString("还没有批处理记录") : text);
+}
+
+QString BarcodeWidget::stageTimingText() const {
+    if (lastStageTimings.empty()) {
+        return {};
+    }
+    const auto duration = [](std::uint64_t ns) {
+        if (ns < 1'000'000)
+            return QString("%1 µs").arg(ns / 1e3, 0, 'f', 1);
+        if (ns < 1'000'000'000)
+            return QString("%1 ms").arg(ns / 1e6, 0, 'f', 1);
+        return QString("%1 s").arg(ns / 1e9, 0, 'f', 2);
+    };
+
+    // 各阶段在多个线程中并行，总计是各线程耗时之和，可能超过批次的实际耗时
+    QString text = QString("[各阶段耗时]（批次共 %1，总计为各线程之和）:").arg(duration(static_cast<std::uint64_t>(lastBatchNsecs)));
+    for (const auto& s : lastStageTimings) {
+        const auto label = timing::stage_label(s.s);
+        text += QString("\n%1: %2 次, 总计 %3, p50 %4, p90 %5, p99 %6, 最大 %7")
+                    .arg(QString::fromUtf8(label.data(), static_cast<int>(label.size())))
+                    .arg(s.count)
+                    .arg(duration(s.total), duration(s.p50), duration(s.p90), duration(s.p99), duration(s.max));
+    }
+    return text;
+}
+
 QImage BarcodeWidget::MatToQImage(const cv::Mat& mat) const {
     if (mat.type() == CV_8UC1)
         return QImage(mat.data, mat.cols, mat.rows, static_cast<int>(mat.step), QImage::Format_Grayscale8).copy();
@@ -816,6 +929,25 @@ QImage BarcodeWidget::MatToQImage(const cv::Mat& mat) const {
 }
 
 void BarcodeWidget::renderResults() const {
+    if (lastResults.size() > 1 || streamingResults) {
+        // 多个结果或批处理进行中：虚拟化列表，只绘制视口内的格子，缩略图在第一次绘制时才生成
+        resultModel->refresh();
+        auto* view = new QListView();
+        view->setViewMode(QListView::IconMode);
+        view->setResizeMode(QListView::Adjust);
+        view->setMovement(QListView::Static);
+        view->setUniformItemSizes(true);
+        view->setLayoutMode(QListView::Batched);
+        view->setSpacing(20);
+        view->setSelectionMode(QAbstractItemView::NoSelection);
+        view->setMouseTracking(true);
+        view->setStyleSheet("QListView { background-color: transparent; border: none; }");
+        view->setItemDelegate(new ResultItemDelegate(view));
+        view->setModel(resultModel);
+        scrollArea->setWidget(view);
+        return;
+    }
+
     QWidget* container = new QWidget();
     // 容器背景设为透明或跟随 ScrollArea
     container->setStyleSheet("background-color: transparent;");
@@ -830,8 +962,6 @@ void BarcodeWidget::renderResults() const {
         return;
     }
 
-    constexpr int maxColumns = 4; // 每行最多4个 (仅用于多结果)
-
     if (lastResults.empty()) {
         if (!lastSelectedFiles.empty()) {
             QVBoxLayout* listLayout = new QVBoxLayout(container);
@@ -932,20 +1062,34 @@ void BarcodeWidget::renderResults() const {
 
         QWidget* contentWidget = nullptr;
 
-        std::visit(overload_def_noop{
-                std::in_place_type<void>,
-                [&](const QImage& img) {
-                    QLabel* imgLabel = new QLabel();
-                    imgLabel->setPixmap(QPixmap::fromImage(img));
-                    imgLabel->setAlignment(Qt::AlignCenter);
-                    imgLabel->setStyleSheet("border: 1px solid #ddd; background: white;");
-                    imgLabel->setToolTip(QString("Size: %1x%2").arg(img.width()).arg(img.height()));
+        const auto showImage = [&](const QImage& img) {
+            QLabel* imgLabel = new QLabel();
+            imgLabel->setAlignment(Qt::AlignCenter);
+            imgLabel->setStyleSheet("border: 1px solid #ddd; background: white;");
+            if (!entry.saved_path.isEmpty()) {
+                // 已直接写盘，只有缩略图
+                if (entry.thumbnail.isNull())
+                    imgLabel->setText("已保存");
+                else
+                    imgLabel->setPixmap(QPixmap::fromImage(entry.thumbnail));
+                imgLabel->setToolTip(QDir::toNativeSeparators(entry.saved_path));
+                contentWidget = imgLabel;
+                return;
+            }
+            imgLabel->setPixmap(QPixmap::fromImage(img));
+            imgLabel->setToolTip(QString("Size: %1x%2").arg(img.width()).arg(img.height()));
 
-                    // [修改] 将最小尺寸设置为图片尺寸，确保大图能撑开 ScrollArea 出现滚动条
-                    imgLabel->setMinimumSize(img.size());
+            // [修改] 将最小尺寸设置为图片尺寸，确保大图能撑开 ScrollArea 出现滚动条
+            imgLabel->setMinimumSize(img.size());
 
-                    contentWidget = imgLabel;
-                },
+            contentWidget = imgLabel;
+        };
+
+        std::visit(overload_def_noop{
+                std::in_place_type<void>,
+                showImage,
+                // 模块矩阵在显示时才光栅化
+                [&](const convert::module_matrix& modules) { showImage(modules.render()); },
                 [&](const QByteArray& data) {
                     QLabel* textLabel = new QLabel();
                     // 显示完整解码内容
@@ -978,101 +1122,83 @@ void BarcodeWidget::renderResults() const {
         if(contentWidget) {
             singleLayout->addWidget(contentWidget, 1); // 权重设为 1 占据空间
         }
-    } else {
-        // --- 多个结果网格展示逻辑 (保持原样) ---
-        QGridLayout* gridLayout = new QGridLayout(container);
-        gridLayout->setHorizontalSpacing(20);
-        gridLayout->setVerticalSpacing(40);
-        gridLayout->setContentsMargins(20, 20, 20, 20);
-
-        int count = 0;
-
-        for (const auto& entry : lastResults) {
-            int row = count / maxColumns;
-            int col = count % maxColumns;
-
-            QWidget* cellWidget = new QWidget();
-            QVBoxLayout* cellLayout = new QVBoxLayout(cellWidget);
-            cellLayout->setContentsMargins(0, 0, 0, 0);
-            cellLayout->setSpacing(5);
-
-            QWidget* contentWidget = nullptr;
-
-            std::visit(overload_def_noop{ std::in_place_type<void>,
-                // 图片类型，显示缩略图
-               [&](const QImage& img) {
-                   QLabel* imgLabel = new QLabel();
-                   // 使用缩略图大小 200x200
-                   imgLabel->setPixmap(QPixmap::fromImage(img).scaled(
-                       200, 200, Qt::KeepAspectRatio, Qt::SmoothTransformation));
-                   imgLabel->setAlignment(Qt::AlignCenter);
-                   imgLabel->setStyleSheet("border: 1px solid #ddd; background: white;");
-                   imgLabel->setToolTip(QString("Size: %1x%2").arg(img.width()).arg(img.height()));
-                   contentWidget = imgLabel;
-               },
-                // 文本类型，显示前200字符 (截断)
-               [&](const QByteArray& data) {
-                   QLabel* textLabel = new QLabel();
-                   QString textDisplay = QString::fromUtf8(data);
-                   if (textDisplay.length() > 256) {
-                       textDisplay = textDisplay.left(256) + "...";
-                   }
-                   textLabel->setText(textDisplay);
-                   textLabel->setWordWrap(true);
-
-                   textLabel->setAlignment(Qt::AlignTop | Qt::AlignLeft);
-
-                   textLabel->setStyleSheet(
-                       "border: 1px solid #ddd; background: white; padding: 5px; font-family: Consolas;");
-                   textLabel->setFixedSize(200, 200);
-                   contentWidget = textLabel;
-               },
-                // 错误信息，显示解码或生成的错误内容
-               [&](const std::string& str) {
-                   QLabel* errLabel = new QLabel(QString::fromStdString(str));
-                   errLabel->setStyleSheet(
-                       "font-size: 15pt; color: red; border: 1px solid red; background: #fff0f0; padding: 5px;");
-                   errLabel->setWordWrap(true);
-
-                   errLabel->setAlignment(Qt::AlignTop | Qt::AlignLeft);
-
-                   errLabel->setFixedSize(200, 200);
-                   contentWidget = errLabel;
-               } },
-                entry.data);
-
-            if (contentWidget) {
-                // 仅在多结果模式下渲染文件名
-                QString fileNameStr = QFileInfo(entry.source_file_name).fileName();
-                if (fileNameStr.isEmpty())
-                    fileNameStr = "Unknown";
-
-                QLabel* nameLabel = new QLabel(fileNameStr);
-                nameLabel->setAlignment(Qt::AlignCenter);
-                nameLabel->setStyleSheet("font-size: 10pt; color: #333; font-weight: bold;");
-                nameLabel->setFixedWidth(200);
-                nameLabel->setToolTip(entry.source_file_name);
-
-
-                QFontMetrics metrics(nameLabel->font());
-                QString      elidedText = metrics.elidedText(fileNameStr, Qt::ElideMiddle, 200);
-                nameLabel->setText(elidedText);
-
-                cellLayout->addWidget(nameLabel);
-
-                cellLayout->addWidget(contentWidget);
-
-                gridLayout->addWidget(cellWidget, row, col, Qt::AlignTop);
-            }
-            count++;
-        }
     }
 
     scrollArea->setWidget(container);
 }
 
-void BarcodeWidget::onBatchFinish(QFutureWatcher<convert::result_data_entry>& watcher) {
+void BarcodeWidget::beginBatch(QFutureWatcherBase* watcher, int total, bool collectResults, std::function<void()> cancel) {
+    runningBatch  = watcher;
+    cancelBatch   = cancel ? std::move(cancel) : [watcher] { watcher->cancel(); };
+    batchCanceled = false;
+    connect(watcher, &QFutureWatcherBase::progressValueChanged, progressBar, &QProgressBar::setValue);
+    // 输入还在枚举时总数随之增长
+    connect(watcher, &QFutureWatcherBase::progressRangeChanged, progressBar, &QProgressBar::setRange);
+
+    progressBar->setVisible(true);
+    progressBar->setRange(0, total); // 设置进度条范围
+    progressBar->setValue(0);
+    generateButton->setEnabled(false);
+    decodeToChemFile->setEnabled(false);
+    saveButton->setEnabled(false);
+    cancelButton->setEnabled(true);
+    cancelButton->setVisible(true);
+    this->setCursor(Qt::WaitCursor);
+
+    // 各阶段耗时按批次统计
+    timing::stage_timings::global().reset();
+    batchTimer.start();
+
+    if (collectResults) {
+        // 先切换到空的结果列表，结果完成一条追加一条
+        streamingResults = true;
+        lastResults.clear();
+        renderResults();
+    }
+}
+
+void BarcodeWidget::endBatch() {
+    if (runningBatch && (batchCanceled || runningBatch->isCanceled())) {
+        spdlog::info("批处理已取消，完成 {}/{}", runningBatch->progressValue(), runningBatch->progressMaximum());
+    }
+    runningBatch     = nullptr;
+    cancelBatch      = {};
+    streamingResults = false;
+
+    lastBatchNsecs   = batchTimer.nsecsElapsed();
+    lastStageTimings = timing::stage_timings::global().summarize();
+    spdlog::info("stage_timings {}",
+        nlohmann::json{{"elapsed_ms", lastBatchNsecs / 1e6}, {"stages", timing::to_json(lastStageTimings)}}.dump());
+    stageTimingsAction->setEnabled(!lastStageTimings.empty());
+
+    cancelButton->setVisible(false);
+    progressBar->setVisible(false);
     setCursor(Qt::ArrowCursor);
+}
+
+void BarcodeWidget::onResultsReady(QFutureWatcher<convert::result_data_entry>& watcher, int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+        lastResults.push_back(watcher.resultAt(i));
+    }
+    resultModel->appendNewRows();
+}
+
+void BarcodeWidget::onResultsReady(QFutureWatcher<std::vector<convert::result_data_entry>>& watcher, int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+        std::ranges::copy(watcher.resultAt(i), std::back_inserter(lastResults));
+    }
+    resultModel->appendNewRows();
+}
+
+void BarcodeWidget::onBatchFinish(QFutureWatcherBase& watcher) {
+    // 结果已由 onResultsReady 逐条收进 lastResults；取消时保留已完成的部分
+    applyBatchResults(std::exchange(lastResults, {}));
+
+    watcher.deleteLater();
+}
+
+void BarcodeWidget::applyBatchResults(std::vector<convert::result_data_entry>&& results) {
+    endBatch();
     if(lastSelectedFiles.size() == 1) {
         auto& file = lastSelectedFiles.front();
         bool isImage = fileExtensionRegex_image.match(file).hasMatch();
@@ -1083,22 +1209,34 @@ void BarcodeWidget::onBatchFinish(QFutureWatcher<convert::result_data_entry>& wa
         decodeToChemFile->setEnabled(true);
     }
 
-    progressBar->setVisible(false);
+    // 解码结果中属于同一文件的多个分片拼回原始数据
+    lastResults = convert::reassemble_sequences(std::move(results));
 
-    QList<convert::result_data_entry> results = watcher.future().results();
+    // 已直接写盘的结果不需要再保存
+    saveButton->setEnabled(std::ranges::any_of(lastResults, [](const auto& entry) { return entry && entry.saved_path.isEmpty(); }));
+    renderResults(); // 批量渲染结果
+}
 
-    lastResults.clear();
-    lastResults.reserve(results.size());
-    for (auto& item : results) {
-        lastResults.push_back(std::move(item));
-    }
+void BarcodeWidget::reportStreamSave(const QString& outputDir, int skipped, const workers::dedup_stats& dedup) {
+    const auto saved = std::ranges::count_if(lastResults, [](const auto& entry) { return !entry.saved_path.isEmpty(); });
+    const auto failed = static_cast<qsizetype>(lastResults.size()) - saved;
 
-    if (!lastResults.empty()) {
-        saveButton->setEnabled(true);
-        renderResults(); // 批量渲染结果
+    QString msg = QString("已保存到: %1\n成功: %2\n失败: %3").arg(QDir::toNativeSeparators(outputDir)).arg(saved).arg(failed);
+    if (skipped > 0) {
+        msg += QString("\n跳过上次已完成的文件: %1").arg(skipped);
+    }
+    if (dedup.duplicates > 0) {
+        msg += QString("\n内容重复的文件: %1（%2 种内容，少编码 %3 MiB）")
+                   .arg(dedup.duplicates).arg(dedup.distinct()).arg(dedup.saved_bytes / (1024.0 * 1024.0), 0, 'f', 1);
+    }
+    if (const QString timings = stageTimingText(); !timings.isEmpty()) {
+        msg += "\n\n" + timings;
+    }
+    if (failed > 0) {
+        QMessageBox::warning(this, "保存结果 - 包含错误", msg);
+    } else {
+        QMessageBox::information(this, "保存成功", msg);
     }
-
-    watcher.deleteLater();
 }
 
 
@@ -1,13 +1,21 @@
 #pragma once
 
+#include <functional>
 #include <vector>
 
+#include <QActionGroup>
+#include <QElapsedTimer>
 #include <QWidget>
 #include <ZXing/BarcodeFormat.h>
 #include <opencv2/opencv.hpp>
 #include <qfuturewatcher.h>
 
+#include "barcode_cache.h"
+#include "batch_dedup.h"
 #include "convert.h"
+#include "image_writer.h"
+#include "pipeline.h"
+#include "stage_timing.h"
 #include "mqtt/mqtt_client.h"
 #include "mqtt/MQTTMessageWidget.h"
 #include "CameraWidget.h"
@@ -21,6 +29,7 @@ class QComboBox;
 class QFileDialog;
 class QProgressBar;
 class QMenuBar;
+class ResultListModel;
 
 /**
  * @class BarcodeWidget
@@ -39,6 +48,11 @@ public:
      */
     explicit BarcodeWidget(QWidget* parent = nullptr);
 
+    /**
+     * @brief 取消正在运行的批处理，线程池析构时不必等后台枚举走完整个目录树
+     */
+    ~BarcodeWidget() override;
+
 private:
     static const QStringList barcodeFormats;
 
@@ -65,6 +79,11 @@ private slots:
      */
     void onBrowseFile() const;
 
+    /**
+     * @brief 选择一个目录作为输入，生成或解码时在后台递归枚举其中的文件
+     */
+    void onBrowseDirectory();
+
     /**
      * @brief 成条码并显示。
      */
@@ -90,6 +109,11 @@ private slots:
      */
     void showMqttDebugMonitor() const;
 
+    /**
+     * @brief 显示上一批处理各阶段的耗时统计
+     */
+    void showStageTimings();
+
     /**
      * @brief 将 OpenCV 中的 Mat 对象转换为 QImage 格式。
      */
@@ -101,10 +125,57 @@ private slots:
     void renderResults() const;
 
     /**
-    * @brief 批处理完成回调函数
+    * @brief 批处理开始：显示进度条和取消按钮，禁用操作按钮
+    * @param watcher 本批任务的监视器
+    * @param total 任务总数
+    * @param collectResults 为 true 时清空 lastResults，结果完成一条显示一条
+    * @param cancel 取消按钮的动作，流水线批次传入其输入队列的 cancel，在途的项完成并报告结果后才结束；
+    *               为空时取消 watcher（取消后完成的结果会被丢弃）
+    */
+    void beginBatch(QFutureWatcherBase* watcher, int total, bool collectResults, std::function<void()> cancel = {});
+
+    /**
+    * @brief 批处理结束（完成或取消）：隐藏进度条和取消按钮，汇总各阶段耗时并写入日志
+    */
+    void endBatch();
+
+    /**
+    * @brief 上一批处理各阶段耗时的文字说明，附在汇总对话框之后；没有记录时为空
+    */
+    [[nodiscard]] QString stageTimingText() const;
+
+    /**
+    * @brief 收下已完成的结果，追加到 lastResults 并插入结果列表
     * @param watcher 异步任务监视器
+    * @param begin 第一条结果的序号
+    * @param end 最后一条结果的下一个序号
+    */
+    void onResultsReady(QFutureWatcher<convert::result_data_entry>& watcher, int begin, int end);
+
+    /**
+    * @brief 整页识别的结果回调，每张图片可能产生多条结果
+    */
+    void onResultsReady(QFutureWatcher<std::vector<convert::result_data_entry>>& watcher, int begin, int end);
+
+    /**
+    * @brief 批处理完成或取消后的回调，结果已由 onResultsReady 收集
+    * @param watcher 异步任务监视器
+    */
+    void onBatchFinish(QFutureWatcherBase& watcher);
+
+    /**
+    * @brief 恢复界面状态，重组分片并显示本批结果
+    * @param results 本批全部结果
+    */
+    void applyBatchResults(std::vector<convert::result_data_entry>&& results);
+
+    /**
+    * @brief 显示直接保存模式的汇总（成功、失败数量和输出目录）
+    * @param outputDir 输出目录
+    * @param skipped 按续跑日志跳过的文件数
+    * @param dedup 批次内去重的统计
     */
-    void onBatchFinish(QFutureWatcher<convert::result_data_entry>& watcher);
+    void reportStreamSave(const QString& outputDir, int skipped, const workers::dedup_stats& dedup);
 
     /**
      * @brief 将条码格式枚举转换为字符串表示。
@@ -135,15 +206,33 @@ private:
     QAction* debugMqttAction;                                                 /**< 打开MQTT消息展示窗口 */
     QAction* openCameraScanAction;                                            /**< 启动摄像头扫描条码 */
     QAction* base64CheckAcion;                                                /**< 启用Base64编码/解码 */
+    QMenu* textPackingMenu;                                                   /**< 文本编码子菜单（勾选 Base64 时生效） */
+    QActionGroup* textPackingGroup;                                           /**< 文本编码（自动/Base64/Base45），data 为 convert::text_packing */
+    QAction* binaryAction;                                                    /**< 原始字节模式：不经 Base64 直接写入条码字节模式 */
+    QAction* compressAction;                                                  /**< 生成前先压缩（Base64 或原始字节模式） */
     QAction* directTextAction;                                                /**< 启用文本输入*/
+    QMenu* decodeEffortMenu;                                                  /**< 识别强度子菜单 */
+    QActionGroup* decodeEffortGroup;                                          /**< 识别强度（快速/均衡/全面），data 为 convert::decode_effort */
+    QAction* strictFormatAction;                                              /**< 解码只识别所选格式，失败不再尝试其它格式 */
+    QAction* sheetDecodeAction;                                               /**< 整页识别图片中的全部条码 */
+    QMenu* imageFormatMenu;                                                   /**< 图片保存格式子菜单 */
+    QActionGroup* imageFormatGroup;                                           /**< 图片保存格式，data 为 convert::image_format */
+    QAction* stageTimingsAction;                                              /**< 显示上一批处理各阶段的耗时 */
+    QAction* streamSaveAction;                                                /**< 批量生成时直接写入输出目录，只保留缩略图 */
                                                                               
     QLineEdit* filePathEdit;                                                  /**< 文件路径输入框 */
     QPushButton* generateButton;                                              /**< 生成条码按钮 */
     QPushButton* decodeToChemFile;                                            /**< 解码并保存为化验文件 */
     QPushButton* saveButton;                                                  /**< 保存条码图片按钮 */
+    QPushButton* cancelButton;                                                /**< 取消正在运行的批处理 */
+    QFutureWatcherBase* runningBatch = nullptr;                               /**< 正在运行的批处理，没有时为空 */
+    std::function<void()> cancelBatch;                                        /**< 取消正在运行的批处理，见 beginBatch */
+    bool batchCanceled = false;                                               /**< 正在运行的批处理已被取消按钮取消 */
+    bool streamingResults = false;                                            /**< 批处理结果正在逐条追加到 lastResults */
     QProgressBar* progressBar;                                                /**< 异步进度条 */
     std::vector<convert::result_data_entry> lastResults;                      /**< 上次解码结果 */
     QScrollArea* scrollArea;                                                  /**< 滚动区域 */
+    ResultListModel* resultModel;                                             /**< 多个结果时列表视图的模型，引用 lastResults */
     QComboBox* formatComboBox;                                                /**< 条码格式选择框 */
     ZXing::BarcodeFormat currentBarcodeFormat = ZXing::BarcodeFormat::QRCode; /**< 当前选择的条码格式 */
     QLineEdit* widthInput;                                                    /**< 图片宽度输入框 */
@@ -151,6 +240,13 @@ private:
     QFileDialog* fileDialog;                                                  /**< 文件选择对话框 */
     std::unique_ptr<MqttSubscriber> subscriber_;                              /**< MQTT订阅者实例 */
     std::unique_ptr<MQTTMessageWidget> messageWidget;                         /**< MQTT消息展示窗口 */
+    std::unique_ptr<convert::barcode_cache> barcodeCache;                     /**< 生成结果缓存，重复内容跳过编码 */
+    std::unique_ptr<workers::batch_pools> batchPools;                         /**< 批处理流水线的 I/O 池与 CPU 池，先于 barcodeCache 析构，析构时等待任务结束 */
+    workers::pipeline_config pipelineConfig;                                  /**< 流水线配置，批次内去重的容量也在其中 */
+    QElapsedTimer batchTimer;                                                 /**< 当前批处理开始后的耗时 */
+    qint64 lastBatchNsecs = 0;                                                /**< 上一批处理的总耗时（纳秒） */
+    std::vector<timing::stage_summary> lastStageTimings;                      /**< 上一批处理各阶段的耗时统计 */
+    convert::image_save_options saveOptions;                                  /**< 图片保存参数，格式以菜单为准，PNG 压缩等级来自配置文件 */
     CameraWidget preview;                                                    /**< 摄像头预览窗口 */
 
 };
@@ -0,0 +1,193 @@
+#include "ResultListModel.h"
+
+#include <QFileInfo>
+#include <QDir>
+#include <QPainter>
+
+#include "overload.h"
+
+namespace {
+
+    constexpr int cellPadding  = 10; /**< 格子左右留白 */
+    constexpr int nameHeight   = 20; /**< 文件名一行的高度 */
+    constexpr int nameSpacing  = 5;  /**< 文件名与内容之间的间距 */
+    constexpr int previewChars = 256;
+
+    constexpr int cacheKiB = 64 * 1024; /**< 缩略图缓存容量，约 64 MiB */
+
+} // namespace
+
+ResultListModel::ResultListModel(const std::vector<convert::result_data_entry>& results, QObject* parent) :
+    QAbstractListModel(parent), results_(results), thumbnails_(cacheKiB) {}
+
+void ResultListModel::refresh() {
+    beginResetModel();
+    thumbnails_.clear();
+    rows_ = static_cast<int>(results_.size());
+    endResetModel();
+}
+
+void ResultListModel::appendNewRows() {
+    const int available = static_cast<int>(results_.size());
+    if (available <= rows_) {
+        return;
+    }
+    beginInsertRows({}, rows_, available - 1);
+    rows_ = available;
+    endInsertRows();
+}
+
+int ResultListModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : rows_;
+}
+
+QVariant ResultListModel::data(const QModelIndex& index, int role) const {
+    const int row = index.row();
+    if (!index.isValid() || row >= rows_ || row >= static_cast<int>(results_.size())) {
+        return {};
+    }
+    const auto& entry = results_[row];
+
+    switch (role) {
+    case Qt::DisplayRole: {
+        const QString name = QFileInfo(entry.source_file_name).fileName();
+        return name.isEmpty() ? QString("Unknown") : name;
+    }
+    case Qt::ToolTipRole:
+        if (!entry.saved_path.isEmpty())
+            return QDir::toNativeSeparators(entry.saved_path);
+        return std::visit<QVariant>(overload_def_noop{std::in_place_type<QVariant>,
+                [&](const QImage& img) { return QVariant(QString("Size: %1x%2").arg(img.width()).arg(img.height())); },
+                [&](const convert::module_matrix& modules) {
+                    return QVariant(QString("Size: %1x%2").arg(modules.config.target_width).arg(modules.config.target_height));
+                },
+                [&](const QByteArray&) { return QVariant(entry.source_file_name); }},
+            entry.data);
+    case Qt::DecorationRole: {
+        const QPixmap pixmap = thumbnail(row);
+        return pixmap.isNull() ? QVariant() : QVariant(pixmap);
+    }
+    case KindRole:
+        return static_cast<int>(std::visit<Kind>(overload_def_noop{std::in_place_type<Kind>,
+                [&](const QImage& img) { return img.isNull() && entry.thumbnail.isNull() ? Kind::saved : Kind::image; },
+                [](const convert::module_matrix&) { return Kind::image; },
+                [](const QByteArray&) { return Kind::text; },
+                [](const std::string&) { return Kind::error; }},
+            entry.data));
+    case PreviewRole:
+        return std::visit<QVariant>(overload_def_noop{std::in_place_type<QVariant>,
+                [](const QByteArray& data) {
+                    QString text = QString::fromUtf8(data.left(previewChars * 4));
+                    if (text.length() > previewChars) {
+                        text = text.left(previewChars) + "...";
+                    }
+                    return QVariant(text);
+                },
+                [](const std::string& err) { return QVariant(QString::fromStdString(err)); }},
+            entry.data);
+    default:
+        return {};
+    }
+}
+
+QPixmap ResultListModel::thumbnail(int row) const {
+    if (const QPixmap* cached = thumbnails_.object(row)) {
+        return *cached;
+    }
+
+    // 工作线程已随结果生成缩略图时直接使用，界面线程只做 QPixmap 转换；没有缩略图的结果才在这里生成
+    const auto& entry = results_[row];
+    QImage image      = entry.thumbnail;
+    if (image.isNull()) {
+        image = std::visit<QImage>(overload_def_noop{std::in_place_type<QImage>,
+                [](const QImage& img) {
+                    if (img.isNull() || (img.width() <= thumbnailSize && img.height() <= thumbnailSize))
+                        return img;
+                    return img.scaled(thumbnailSize, thumbnailSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+                },
+                // 模块矩阵直接按缩略图尺寸光栅化，不必先生成整图再缩放
+                [](const convert::module_matrix& modules) { return modules.thumbnail(thumbnailSize); }},
+            entry.data);
+    }
+    if (image.isNull()) {
+        return {};
+    }
+
+    auto* pixmap   = new QPixmap(QPixmap::fromImage(image));
+    const int cost = std::max(1, static_cast<int>(static_cast<qint64>(pixmap->width()) * pixmap->height() * pixmap->depth() / 8 / 1024));
+    const QPixmap result = *pixmap;
+    thumbnails_.insert(row, pixmap, cost);
+    return result;
+}
+
+void ResultItemDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const {
+    using Kind = ResultListModel::Kind;
+    constexpr int box = ResultListModel::thumbnailSize;
+
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing, false);
+
+    const QRect cell = option.rect.adjusted(cellPadding, 0, -cellPadding, 0);
+    const QRect nameRect(cell.left(), cell.top(), box, nameHeight);
+    const QRect contentRect(cell.left(), nameRect.bottom() + 1 + nameSpacing, box, box);
+
+    // 文件名，过长时中间省略
+    QFont nameFont = option.font;
+    nameFont.setPointSize(10);
+    nameFont.setBold(true);
+    painter->setFont(nameFont);
+    painter->setPen(QColor("#333"));
+    const QString name = index.data(Qt::DisplayRole).toString();
+    painter->drawText(nameRect, Qt::AlignCenter, QFontMetrics(nameFont).elidedText(name, Qt::ElideMiddle, box));
+
+    const auto kind   = static_cast<Kind>(index.data(ResultListModel::KindRole).toInt());
+    const bool hover  = option.state & QStyle::State_MouseOver;
+    const bool failed = kind == Kind::error;
+
+    painter->fillRect(contentRect, failed ? QColor("#fff0f0") : QColor(Qt::white));
+
+    switch (kind) {
+    case Kind::image: {
+        const QPixmap pixmap = index.data(Qt::DecorationRole).value<QPixmap>();
+        if (!pixmap.isNull()) {
+            const QSize size = pixmap.size().scaled(contentRect.size(), Qt::KeepAspectRatio).boundedTo(pixmap.size());
+            const QRect target(contentRect.left() + (box - size.width()) / 2, contentRect.top() + (box - size.height()) / 2,
+                size.width(), size.height());
+            painter->drawPixmap(target, pixmap);
+        }
+        break;
+    }
+    case Kind::saved:
+        painter->setFont(option.font);
+        painter->setPen(QColor("#aaa"));
+        painter->drawText(contentRect, Qt::AlignCenter, "已保存");
+        break;
+    case Kind::text:
+    case Kind::error: {
+        QFont textFont = option.font;
+        if (kind == Kind::text) {
+            textFont.setFamily("Consolas");
+        } else {
+            textFont.setPointSize(12);
+        }
+        painter->setFont(textFont);
+        painter->setPen(failed ? QColor(Qt::red) : QColor("#333"));
+        painter->setClipRect(contentRect);
+        painter->drawText(contentRect.adjusted(5, 5, -5, -5), Qt::AlignTop | Qt::AlignLeft | Qt::TextWrapAnywhere,
+            index.data(ResultListModel::PreviewRole).toString());
+        painter->setClipping(false);
+        break;
+    }
+    case Kind::empty:
+        break;
+    }
+
+    painter->setPen(failed ? QColor(Qt::red) : hover ? QColor("#40a9ff") : QColor("#ddd"));
+    painter->drawRect(contentRect.adjusted(0, 0, -1, -1));
+
+    painter->restore();
+}
+
+QSize ResultItemDelegate::sizeHint(const QStyleOptionViewItem&, const QModelIndex&) const {
+    return {ResultListModel::thumbnailSize + 2 * cellPadding, nameHeight + nameSpacing + ResultListModel::thumbnailSize};
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+
+#include <QAbstractListModel>
+#include <QCache>
+#include <QPixmap>
+#include <QStyledItemDelegate>
+
+#include "convert.h"
+
+/**
+ * @class ResultListModel
+ * @brief 批处理结果的列表模型，供 QListView 虚拟化显示
+ *
+ * 只引用 BarcodeWidget::lastResults，不复制结果。缩略图优先使用工作线程随结果生成的 result_data_entry::thumbnail，
+ * 视图第一次绘制某一行时才转换为 QPixmap，放进按像素字节计容量的 QCache，滚出视口的行不再占用内存。
+ * 结果变化后调用 refresh。
+ */
+class ResultListModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 每一项的类型，对应 result_data_entry::data 的各个分支
+     */
+    enum class Kind {
+        empty,
+        image,  /**< 图片或模块矩阵 */
+        saved,  /**< 已直接写盘，没有保留缩略图 */
+        text,   /**< 解码得到的内容 */
+        error,  /**< 错误信息 */
+    };
+
+    enum Role {
+        KindRole = Qt::UserRole + 1, /**< Kind */
+        PreviewRole,                 /**< 文本或错误的预览（最多 256 字符） */
+    };
+
+    /**
+     * @param results 结果列表，须比模型活得久
+     * @param parent 父对象
+     */
+    explicit ResultListModel(const std::vector<convert::result_data_entry>& results, QObject* parent = nullptr);
+
+    /**
+     * @brief 结果列表整体变化后重置模型并清空缩略图缓存
+     */
+    void refresh();
+
+    /**
+     * @brief 结果列表末尾追加了新结果后调用，只插入新增的行，已显示的行和缩略图缓存不受影响
+     */
+    void appendNewRows();
+
+    [[nodiscard]] int rowCount(const QModelIndex& parent = {}) const override;
+    [[nodiscard]] QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    static constexpr int thumbnailSize = 200; /**< 缩略图边长 */
+
+private:
+    /**
+     * @brief 取缩略图，缓存未命中时生成
+     */
+    QPixmap thumbnail(int row) const;
+
+    const std::vector<convert::result_data_entry>& results_;
+    int rows_ = 0;                               /**< 上次 refresh 时的行数，结果被清空到下次 refresh 之间不越界 */
+    mutable QCache<int, QPixmap> thumbnails_;    /**< 行号 -> 缩略图，容量按 KiB 计 */
+};
+
+/**
+ * @class ResultItemDelegate
+ * @brief 结果网格中一格的绘制：上方文件名，下方 200x200 的缩略图、文本预览或错误信息
+ *
+ * 不为每一项创建控件，视图滚动时只重绘可见的格子。
+ */
+class ResultItemDelegate : public QStyledItemDelegate {
+    Q_OBJECT
+
+public:
+    using QStyledItemDelegate::QStyledItemDelegate;
+
+    void paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+    [[nodiscard]] QSize sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+};
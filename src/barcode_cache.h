@@ -0,0 +1,324 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QSaveFile>
+#include <QString>
+#include <QStringList>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+#include "convert.h"
+
+namespace convert {
+
+    /**
+     * @brief 条码缓存配置
+     */
+    struct barcode_cache_config {
+        std::size_t memory_bytes = 256ull * 1024 * 1024; /**< 内存层容量（字节），0 表示不启用内存层 */
+        QString disk_dir;                                 /**< 磁盘层目录，为空表示不启用磁盘层 */
+        std::uint64_t disk_bytes = 1024ull * 1024 * 1024; /**< 磁盘层容量（字节），超出后按修改时间删除最旧的文件；0 表示不限 */
+    };
+
+    /**
+     * @class barcode_cache
+     * @brief 以内容哈希为键的条码缓存
+     *
+     * 键由原始负载、QRcode_create_config 以及 Base64、压缩开关共同计算（SHA-256），
+     * 内容相同且参数相同的条目直接复用已生成的模块矩阵，不再经过 ZXing。
+     * 内存层为按字节计容量的 LRU；磁盘层可选，按键的前两位分目录保存为每模块一个像素的 PNG，
+     * 光栅化参数记在 PNG 的文本块中。磁盘层超过 disk_bytes 时删除修改时间最早的文件，降到容量的 90%；
+     * 磁盘命中会刷新文件的修改时间，删除顺序近似 LRU。
+     * 所有接口线程安全，可在 QtConcurrent 的工作线程中直接调用。
+     */
+    class barcode_cache {
+    public:
+        explicit barcode_cache(barcode_cache_config config = {}) : config_(std::move(config)) {
+            if (!config_.disk_dir.isEmpty()) {
+                QDir().mkpath(config_.disk_dir);
+                if (config_.disk_bytes > 0) {
+                    // 统计已有文件的总大小，上次运行后调小了容量时顺带清理
+                    std::lock_guard lock(disk_mutex_);
+                    prune_disk();
+                }
+            }
+        }
+
+        /**
+         * @brief 从配置文件的 "cache" 节读取缓存配置，缺省项保持默认值
+         */
+        static barcode_cache_config loadCacheConfig(const std::string& filename) {
+            barcode_cache_config config;
+
+            std::ifstream file(filename);
+            if (!file.is_open()) {
+                return config;
+            }
+
+            const auto json = nlohmann::json::parse(file, nullptr, false);
+            if (json.is_discarded() || !json.contains("cache")) {
+                return config;
+            }
+
+            const auto& cache_cfg = json["cache"];
+            if (cache_cfg.contains("memory_mb"))
+                config.memory_bytes = cache_cfg["memory_mb"].get<std::size_t>() * 1024 * 1024;
+            if (cache_cfg.contains("disk_dir"))
+                config.disk_dir = QString::fromStdString(cache_cfg["disk_dir"].get<std::string>());
+            if (cache_cfg.contains("disk_mb"))
+                config.disk_bytes = cache_cfg["disk_mb"].get<std::uint64_t>() * 1024 * 1024;
+            return config;
+        }
+
+        /**
+         * @brief 计算缓存键
+         * @param payload 原始负载（文件内容或输入文本的 UTF-8 字节），可以直接指向内存映射的文件
+         * @param config 生成参数
+         * @param mode 负载写入方式（文本、Base64 或原始字节）
+         * @param compress 是否尝试压缩
+         * @param prefix 负载之前额外写入条码的内容（如分片头）
+         * @return 十六进制的 SHA-256 摘要
+         */
+        [[nodiscard]] static std::string make_key(std::span<const std::uint8_t> payload, const QRcode_create_config& config,
+                                                  payload_mode mode, bool compress, std::string_view prefix = {}) {
+            // 光栅化规则变化时递增，避免命中旧版本生成的图片
+            constexpr std::int32_t key_version = 3; // 2：图片带有模块网格信息；3：缓存模块矩阵而不是图片
+            const std::int32_t params[] = {
+                key_version,
+                config.target_width,
+                config.target_height,
+                static_cast<std::int32_t>(config.format),
+                config.margin,
+                static_cast<std::int32_t>(mode), // text/base64 与旧版本的 0/1 一致
+                compress ? 1 : 0,
+            };
+
+            QCryptographicHash hash(QCryptographicHash::Sha256);
+            hash.addData(reinterpret_cast<const char*>(params), sizeof(params));
+            hash.addData(prefix.data(), static_cast<int>(prefix.size()));
+            hash.addData(reinterpret_cast<const char*>(payload.data()), static_cast<int>(payload.size()));
+            return hash.result().toHex().toStdString();
+        }
+
+        /**
+         * @brief 查找缓存，依次尝试内存层和磁盘层，磁盘命中会提升到内存层
+         */
+        [[nodiscard]] std::optional<module_matrix> find(const std::string& key) {
+            {
+                std::lock_guard lock(mutex_);
+                if (const auto it = index_.find(key); it != index_.end()) {
+                    entries_.splice(entries_.begin(), entries_, it->second);
+                    ++memory_hits_;
+                    return it->second->modules;
+                }
+            }
+
+            if (!config_.disk_dir.isEmpty()) {
+                QImage image;
+                const QString path = disk_path(key);
+                if (image.load(path, "PNG")) {
+                    if (const auto config = load_render_config(image)) {
+                        ++disk_hits_;
+                        if (config_.disk_bytes > 0) {
+                            touch(path);
+                        }
+                        auto modules = module_matrix::from_module_image(image, *config);
+                        insert_memory(key, modules);
+                        return modules;
+                    }
+                }
+            }
+
+            ++misses_;
+            return std::nullopt;
+        }
+
+        /**
+         * @brief 写入缓存（内存层，以及启用时的磁盘层）
+         */
+        void store(const std::string& key, const module_matrix& modules) {
+            if (modules.empty()) {
+                return;
+            }
+            insert_memory(key, modules);
+
+            if (!config_.disk_dir.isEmpty()) {
+                const QString path = disk_path(key);
+                if (QFileInfo::exists(path)) {
+                    return;
+                }
+                QDir().mkpath(QFileInfo(path).absolutePath());
+                // 先写临时文件再改名，并发写同一个键也不会留下半截文件
+                QImage image = modules.module_image();
+                store_render_config(image, modules.config);
+                QSaveFile file(path);
+                if (file.open(QIODevice::WriteOnly) && image.save(&file, "PNG")) {
+                    const auto written = static_cast<std::uint64_t>(file.size());
+                    if (file.commit()) {
+                        account_disk(written);
+                    }
+                } else {
+                    file.cancelWriting();
+                }
+            }
+        }
+
+        /**
+         * @brief 将命中/未命中计数写入日志
+         */
+        void logStats() const {
+            const auto memory = memory_hits_.load();
+            const auto disk   = disk_hits_.load();
+            const auto misses = misses_.load();
+            std::lock_guard lock(mutex_);
+            spdlog::info("条码缓存: 命中 {} (内存 {}, 磁盘 {}), 未命中 {}, 内存占用 {:.1f} MiB / {} 项",
+                memory + disk, memory, disk, misses, memory_used_ / (1024.0 * 1024.0), entries_.size());
+        }
+
+    private:
+        struct entry {
+            std::string key;
+            module_matrix modules;
+        };
+
+        static constexpr const char* render_key = "L2Q-Render";
+
+        static void store_render_config(QImage& image, const QRcode_create_config& config) {
+            image.setText(render_key, QString("%1,%2,%3,%4").arg(config.target_width).arg(config.target_height)
+                                          .arg(static_cast<std::int32_t>(config.format)).arg(config.margin));
+        }
+
+        [[nodiscard]] static std::optional<QRcode_create_config> load_render_config(const QImage& image) {
+            const QStringList fields = image.text(render_key).split(',');
+            if (fields.size() != 4) {
+                return std::nullopt;
+            }
+            return QRcode_create_config{fields[0].toInt(), fields[1].toInt(),
+                static_cast<ZXing::BarcodeFormat>(fields[2].toInt()), fields[3].toInt()};
+        }
+
+        static void touch(const QString& path) {
+            QFile file(path);
+            if (file.open(QIODevice::ReadWrite)) {
+                file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+            }
+        }
+
+        /**
+         * @brief 记入新写的文件，超出容量时由一个线程清理，其余线程不等待
+         */
+        void account_disk(std::uint64_t bytes) {
+            if (config_.disk_bytes == 0 || (disk_used_ += bytes) <= config_.disk_bytes) {
+                return;
+            }
+            std::unique_lock lock(disk_mutex_, std::try_to_lock);
+            if (lock.owns_lock()) {
+                prune_disk();
+            }
+        }
+
+        /**
+         * @brief 重新统计磁盘层的总大小，超出容量时按修改时间从旧到新删除，降到容量的 90%
+         *
+         * 调用方须持有 disk_mutex_。
+         */
+        void prune_disk() {
+            struct cached_file {
+                QString path;
+                std::uint64_t size;
+                QDateTime modified;
+            };
+            std::vector<cached_file> files;
+            std::uint64_t total = 0;
+            QDirIterator it(config_.disk_dir, {"*.png"}, QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext()) {
+                it.next();
+                const QFileInfo info = it.fileInfo();
+                files.push_back({info.filePath(), static_cast<std::uint64_t>(info.size()), info.lastModified()});
+                total += files.back().size;
+            }
+
+            if (total > config_.disk_bytes) {
+                std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) { return a.modified < b.modified; });
+                const std::uint64_t target = config_.disk_bytes / 10 * 9;
+                std::size_t removed = 0;
+                for (const auto& file : files) {
+                    if (total <= target) {
+                        break;
+                    }
+                    if (QFile::remove(file.path)) {
+                        total -= file.size;
+                        ++removed;
+                    }
+                }
+                spdlog::info("条码磁盘缓存超过 {} MiB，删除了 {} 个最旧的文件，剩余 {:.1f} MiB",
+                    config_.disk_bytes / (1024 * 1024), removed, total / (1024.0 * 1024.0));
+            }
+            disk_used_ = total;
+        }
+
+        QString disk_path(const std::string& key) const {
+            const QString hex = QString::fromStdString(key);
+            return QDir(config_.disk_dir).filePath(hex.left(2) + "/" + hex + ".png");
+        }
+
+        void insert_memory(const std::string& key, const module_matrix& modules) {
+            const auto bytes = modules.byte_size();
+            if (bytes > config_.memory_bytes) {
+                return;
+            }
+
+            std::lock_guard lock(mutex_);
+            if (const auto it = index_.find(key); it != index_.end()) {
+                entries_.splice(entries_.begin(), entries_, it->second);
+                return;
+            }
+
+            entries_.push_front({key, modules});
+            index_.emplace(key, entries_.begin());
+            memory_used_ += bytes;
+
+            while (memory_used_ > config_.memory_bytes && !entries_.empty()) {
+                const auto& last  = entries_.back();
+                memory_used_     -= last.modules.byte_size();
+                index_.erase(last.key);
+                entries_.pop_back();
+            }
+        }
+
+        barcode_cache_config config_;
+
+        mutable std::mutex mutex_;
+        std::list<entry> entries_;                                                /**< 最近使用的在前 */
+        std::unordered_map<std::string, std::list<entry>::iterator> index_;
+        std::size_t memory_used_ = 0;
+
+        std::mutex disk_mutex_;                 /**< 同一时间只有一个线程清理磁盘层 */
+        std::atomic<std::uint64_t> disk_used_{0}; /**< 磁盘层的总大小，只在启用容量限制时统计 */
+
+        std::atomic<std::uint64_t> memory_hits_{0};
+        std::atomic<std::uint64_t> disk_hits_{0};
+        std::atomic<std::uint64_t> misses_{0};
+    };
+
+} // namespace convert
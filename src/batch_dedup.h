@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+namespace workers {
+
+    /**
+     * @brief 批次内去重的统计
+     */
+    struct dedup_stats {
+        std::uint64_t inputs      = 0; /**< 参与去重的输入数 */
+        std::uint64_t duplicates  = 0; /**< 内容与之前某个输入相同、直接复用结果的输入数 */
+        std::uint64_t saved_bytes = 0; /**< 因复用而少编码的输入字节数 */
+
+        [[nodiscard]] std::uint64_t distinct() const noexcept { return inputs - duplicates; }
+    };
+
+    /**
+     * @brief 去重计数，与结果类型无关，界面只持有这一部分用于汇总
+     */
+    class dedup_counter {
+    public:
+        [[nodiscard]] dedup_stats stats() const {
+            return {inputs_.load(std::memory_order_relaxed), duplicates_.load(std::memory_order_relaxed),
+                saved_bytes_.load(std::memory_order_relaxed)};
+        }
+
+        /**
+         * @brief 将去重统计写入日志
+         */
+        void logStats() const {
+            const auto s = stats();
+            spdlog::info("批次去重: {} 个输入, {} 种内容, 复用 {} 个, 少编码 {:.1f} MiB", s.inputs, s.distinct(), s.duplicates,
+                s.saved_bytes / (1024.0 * 1024.0));
+        }
+
+    protected:
+        void count(bool shared, std::uint64_t bytes) {
+            inputs_.fetch_add(1, std::memory_order_relaxed);
+            if (shared) {
+                duplicates_.fetch_add(1, std::memory_order_relaxed);
+                saved_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        std::atomic<std::uint64_t> inputs_{0};
+        std::atomic<std::uint64_t> duplicates_{0};
+        std::atomic<std::uint64_t> saved_bytes_{0};
+    };
+
+    /**
+     * @class batch_dedup
+     * @brief 同一批次内按输入内容的 SHA-256 去重：每种内容只计算一次，内容相同的输入共享结果
+     *
+     * 与 barcode_cache 不同，这里的键只是读取阶段顺带算出的内容摘要，不再对负载重新哈希；
+     * 同一份内容的第二个输入在第一个仍在编码时到达，会等它完成后复用结果，而不是并行地再编码一遍。
+     * 批次内的生成参数固定，所以每个批次各用一个实例，键中不必包含参数。
+     *
+     * 只保留最近完成的 capacity 份结果，相隔很远的重复内容会重新计算，批次再大占用也有上限。
+     * 所有接口线程安全。
+     *
+     * @tparam Value 共享的结果，须可复制；复用者拿到的是副本，按自己的文件名修改后使用
+     */
+    template <typename Value>
+    class batch_dedup : public dedup_counter {
+    public:
+        static constexpr std::size_t default_capacity = 4096;
+
+        explicit batch_dedup(std::size_t capacity = default_capacity) : capacity_(std::max<std::size_t>(capacity, 1)) {}
+
+        /**
+         * @brief 取内容为 digest 的结果，第一次出现时调用 compute 计算
+         * @param digest 输入内容的摘要
+         * @param bytes 输入的字节数，只用于统计
+         * @param compute 无参调用，返回 Value；抛出的异常同样传给等待中的复用者
+         * @return 结果，以及是否复用了别的输入的结果
+         */
+        template <typename Compute>
+        std::pair<Value, bool> share(const std::string& digest, std::uint64_t bytes, Compute&& compute) {
+            std::promise<Value> promise;
+            std::shared_future<Value> future;
+            bool shared = false;
+            {
+                std::lock_guard lock(mutex_);
+                if (const auto it = index_.find(digest); it != index_.end()) {
+                    shared = true;
+                    future = it->second.future;
+                    if (it->second.done) {
+                        recent_.splice(recent_.begin(), recent_, it->second.position);
+                    }
+                } else {
+                    future = promise.get_future().share();
+                    index_.emplace(digest, slot{future});
+                }
+            }
+            count(shared, bytes);
+            if (shared) {
+                // 计算者在拿到槽位后立即开始计算，不会等待其它任务，这里最多等一次编码的时间
+                return {future.get(), true};
+            }
+
+            try {
+                Value value = compute();
+                promise.set_value(value);
+                finish(digest);
+                return {std::move(value), false};
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+                std::lock_guard lock(mutex_);
+                index_.erase(digest);
+                throw;
+            }
+        }
+
+    private:
+        struct slot {
+            std::shared_future<Value> future;
+            bool done = false;
+            std::list<std::string>::iterator position{}; /**< done 之后在 recent_ 中的位置 */
+        };
+
+        void finish(const std::string& digest) {
+            std::lock_guard lock(mutex_);
+            const auto it = index_.find(digest);
+            if (it == index_.end()) {
+                return;
+            }
+            recent_.push_front(digest);
+            it->second.done     = true;
+            it->second.position = recent_.begin();
+            // 只淘汰已完成的结果，计算中的槽位不在 recent_ 中
+            while (recent_.size() > capacity_) {
+                index_.erase(recent_.back());
+                recent_.pop_back();
+            }
+        }
+
+        std::size_t capacity_;
+
+        std::mutex mutex_;
+        std::unordered_map<std::string, slot> index_;
+        std::list<std::string> recent_; /**< 已完成的摘要，最近使用的在前 */
+    };
+
+} // namespace workers
@@ -0,0 +1,293 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace workers {
+
+    /**
+     * @class batch_journal
+     * @brief 批处理的续跑日志：每完成一项追加一行 JSON，进程崩溃或重启后重新运行同一批次时跳过已完成的项
+     *
+     * 第一行记录批次参数的指纹，参数不同说明是另一批任务，旧记录全部作废。之后每行一条记录：
+     * 输入路径与分片序号、输入的大小/修改时间/SHA-256、输出路径和状态。同一项有多条记录时以最后一条为准；
+     * 崩溃时写了一半的最后一行在读入时忽略。
+     *
+     * 续跑时先比较大小和修改时间，一致即认定输入未变，不需要重新读文件，几万条记录几秒内就能核对完；
+     * 修改时间不同（如整个目录被复制过）时才重新计算哈希比较。
+     *
+     * 所有接口线程安全。
+     */
+    class batch_journal {
+    public:
+        static constexpr const char* default_name = ".lab2qrcode-journal.jsonl"; /**< 输出目录中的默认文件名 */
+
+        /**
+         * @brief 一条记录
+         */
+        struct record {
+            QString input;      /**< 输入文件路径 */
+            int part      = 0;  /**< 分片序号，未分片时为 0 */
+            int parts     = 0;  /**< 分片总数，未分片时为 0 */
+            qint64 size   = 0;  /**< 读取时输入文件的大小 */
+            qint64 mtime  = 0;  /**< 读取时输入文件的修改时间（毫秒） */
+            std::string hash;   /**< 输入内容（分片时为该分片）的 SHA-256 */
+            QString output;     /**< 写出的文件 */
+            bool ok = false;    /**< 是否成功；失败的项续跑时重做 */
+        };
+
+        /**
+         * @brief 打开（不存在时创建）日志并读入已有记录
+         * @param settings 本批参数的指纹，与日志中记录的不一致时清空旧记录
+         * @return 无法写入日志时返回 false
+         */
+        bool open(const QString& path, const std::string& settings) {
+            std::lock_guard lock(mutex_);
+            settings_ = settings;
+            records_.clear();
+            file_.close();
+            file_.setFileName(path);
+
+            bool valid     = false;
+            bool lineEnded = true;
+            if (file_.open(QIODevice::ReadOnly)) {
+                bool first = true;
+                while (!file_.atEnd()) {
+                    const QByteArray raw  = file_.readLine();
+                    const QByteArray line = raw.trimmed();
+                    lineEnded             = raw.endsWith('\n');
+                    if (line.isEmpty()) {
+                        continue;
+                    }
+                    const auto json = nlohmann::json::parse(line.constData(), line.constData() + line.size(), nullptr, false);
+                    if (first) {
+                        first = false;
+                        valid = !json.is_discarded() && json.is_object() && json.value("journal", 0) == version
+                            && json.value("settings", std::string{}) == settings;
+                        if (!valid) {
+                            break;
+                        }
+                        continue;
+                    }
+                    if (!json.is_discarded() && json.is_object()) {
+                        try {
+                            load(json);
+                        } catch (const nlohmann::json::exception&) {
+                            // 字段类型不对的记录与写了一半的行一样忽略
+                        }
+                    }
+                }
+                file_.close();
+            }
+
+            if (!valid) {
+                records_.clear();
+                return start_over();
+            }
+            if (!file_.open(QIODevice::WriteOnly | QIODevice::Append)) {
+                spdlog::warn("无法写入续跑日志: {}", path.toStdString());
+                return false;
+            }
+            // 上次崩溃时最后一行可能没写完，先补上换行，新记录另起一行
+            if (!lineEnded) {
+                file_.write("\n");
+            }
+            spdlog::info("续跑日志 {}: {} 项已完成", path.toStdString(), completed_locked());
+            return true;
+        }
+
+        /**
+         * @brief 丢弃全部记录，从头开始
+         */
+        bool reset() {
+            std::lock_guard lock(mutex_);
+            records_.clear();
+            file_.close();
+            return start_over();
+        }
+
+        /**
+         * @brief 成功完成的项数
+         */
+        [[nodiscard]] std::size_t completed_count() const {
+            std::lock_guard lock(mutex_);
+            return completed_locked();
+        }
+
+        /**
+         * @brief 查找某一项的最后一条记录
+         */
+        [[nodiscard]] std::optional<record> find(const QString& input, int part) const {
+            std::lock_guard lock(mutex_);
+            const auto it = records_.find({input, part});
+            if (it == records_.end()) {
+                return std::nullopt;
+            }
+            return it->second;
+        }
+
+        /**
+         * @brief 追加一条记录并立即写入磁盘
+         */
+        void append(record r) {
+            nlohmann::json json{
+                {"input", r.input.toStdString()},
+                {"part", r.part},
+                {"parts", r.parts},
+                {"size", r.size},
+                {"mtime", r.mtime},
+                {"hash", r.hash},
+                {"output", r.output.toStdString()},
+                {"status", r.ok ? "done" : "failed"},
+            };
+            const std::string line = json.dump() + "\n";
+
+            std::lock_guard lock(mutex_);
+            if (file_.isOpen()) {
+                file_.write(line.data(), static_cast<qint64>(line.size()));
+                file_.flush();
+            }
+            records_[{r.input, r.part}] = std::move(r);
+        }
+
+        /**
+         * @brief 输入文件在读取时的大小和修改时间
+         *
+         * 须在读取内容之前取得，与内容摘要一起随任务传到写入阶段；
+         * 写完后再取的话，批次进行中被修改的输入会记成新的修改时间配旧的摘要，续跑时就不再核对哈希。
+         */
+        struct input_stamp {
+            qint64 size  = 0;
+            qint64 mtime = 0;
+
+            [[nodiscard]] static input_stamp of(const QString& path) {
+                const QFileInfo info(path);
+                return {info.size(), info.lastModified().toMSecsSinceEpoch()};
+            }
+        };
+
+        /**
+         * @brief 用读取时取得的大小和修改时间组成一条记录
+         */
+        [[nodiscard]] static record make_record(const QString& input, int part, int parts, input_stamp stamp, std::string hash, QString output, bool ok) {
+            return {input, part, parts, stamp.size, stamp.mtime, std::move(hash), std::move(output), ok};
+        }
+
+        [[nodiscard]] static std::string hash_bytes(std::span<const std::uint8_t> bytes) {
+            QCryptographicHash hash(QCryptographicHash::Sha256);
+            // addData 的长度是 int，超过 2 GiB 的内容分段送入
+            constexpr std::size_t chunk = std::numeric_limits<int>::max();
+            for (std::size_t offset = 0; offset < bytes.size(); offset += chunk) {
+                const std::size_t length = std::min(chunk, bytes.size() - offset);
+                hash.addData(reinterpret_cast<const char*>(bytes.data() + offset), static_cast<int>(length));
+            }
+            return hash.result().toHex().toStdString();
+        }
+
+        /**
+         * @brief 将已写入 file 的内容刷到磁盘（fsync），追加记录之前调用，掉电后不会出现记录为完成而输出文件为空的情况
+         */
+        [[nodiscard]] static bool sync_file(QFile& file) {
+            if (!file.flush()) {
+                return false;
+            }
+#ifdef _WIN32
+            return _commit(file.handle()) == 0;
+#else
+            return ::fsync(file.handle()) == 0;
+#endif
+        }
+
+        /**
+         * @brief 按路径打开已写好的文件并刷到磁盘，用于 QFile::copy 等不经过自己的 QFile 写出的文件
+         */
+        [[nodiscard]] static bool sync_path(const QString& path) {
+            QFile file(path);
+            return file.open(QIODevice::ReadWrite) && sync_file(file);
+        }
+
+        /**
+         * @brief 读取文件的一段计算 SHA-256
+         * @param length 字节数，-1 表示到文件末尾
+         * @return 无法读取时返回空串
+         */
+        [[nodiscard]] static std::string hash_file(const QString& path, qint64 offset = 0, qint64 length = -1) {
+            QFile file(path);
+            if (!file.open(QIODevice::ReadOnly) || !file.seek(offset)) {
+                return {};
+            }
+            QCryptographicHash hash(QCryptographicHash::Sha256);
+            constexpr qint64 chunk = 1 << 20;
+            qint64 remaining       = length < 0 ? file.size() - offset : length;
+            while (remaining > 0) {
+                const QByteArray data = file.read(std::min(chunk, remaining));
+                if (data.isEmpty()) {
+                    break;
+                }
+                hash.addData(data);
+                remaining -= data.size();
+            }
+            return hash.result().toHex().toStdString();
+        }
+
+    private:
+        static constexpr int version = 1;
+
+        void load(const nlohmann::json& json) {
+            record r;
+            r.input  = QString::fromStdString(json.value("input", std::string{}));
+            r.part   = json.value("part", 0);
+            r.parts  = json.value("parts", 0);
+            r.size   = json.value("size", qint64{0});
+            r.mtime  = json.value("mtime", qint64{0});
+            r.hash   = json.value("hash", std::string{});
+            r.output = QString::fromStdString(json.value("output", std::string{}));
+            r.ok     = json.value("status", std::string{}) == "done";
+            if (!r.input.isEmpty()) {
+                records_[{r.input, r.part}] = std::move(r);
+            }
+        }
+
+        bool start_over() {
+            if (!file_.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                spdlog::warn("无法写入续跑日志: {}", file_.fileName().toStdString());
+                return false;
+            }
+            const std::string header = nlohmann::json{{"journal", version}, {"settings", settings_}}.dump() + "\n";
+            file_.write(header.data(), static_cast<qint64>(header.size()));
+            file_.flush();
+            return true;
+        }
+
+        [[nodiscard]] std::size_t completed_locked() const {
+            return static_cast<std::size_t>(std::ranges::count_if(records_, [](const auto& entry) { return entry.second.ok; }));
+        }
+
+        mutable std::mutex mutex_;
+        QFile file_;
+        std::string settings_;
+        std::map<std::pair<QString, int>, record> records_; /**< (输入路径, 分片序号) -> 最后一条记录 */
+    };
+
+} // namespace workers
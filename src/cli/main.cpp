@@ -0,0 +1,424 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+#include "barcode_cache.h"
+#include "convert.h"
+#include "sequence.h"
+#include "stage_timing.h"
+#include "sysinfo.h"
+#include "workers.h"
+#include "version_info/version.h"
+
+/**
+ * @file main.cpp
+ * @brief Lab2QRCode 的无界面批处理入口
+ *
+ * 不创建 QApplication 和任何窗口，直接复用 workers:: 里的生成/解码逻辑，
+ * 处理完一条就写出一条，适合在没有显示器的机器上脚本化处理大量文件。
+ */
+
+namespace {
+
+    const QRegularExpression imageFileRegex(
+        R"(^.*\.(?:png|jpg|jpeg|bmp|gif|tiff|webp)$)",
+        QRegularExpression::CaseInsensitiveOption
+    );
+
+    enum class mode {
+        encode,
+        decode,
+    };
+
+    /**
+     * @brief 一个待处理的输入文件
+     */
+    struct input_item {
+        workers::file_part part; /**< 输入文件（生成时可能只是其中一个分片） */
+        QString relativeDir;     /**< 相对于输入目录的子目录，用于在输出目录中保持层级 */
+    };
+
+    /**
+     * @brief 批处理统计，由各工作线程并发累加
+     */
+    struct batch_stats {
+        std::atomic<std::uint64_t> done{0};
+        std::atomic<std::uint64_t> succeeded{0};
+        std::atomic<std::uint64_t> failed{0};
+        std::atomic<std::uint64_t> skipped{0}; /**< 按续跑日志跳过的文件 */
+        std::atomic<std::uint64_t> inputBytes{0};
+        std::atomic<std::uint64_t> outputBytes{0};
+    };
+
+    bool accepts(mode m, const QString& path) {
+        const bool isImage = imageFileRegex.match(path).hasMatch();
+        return m == mode::decode ? isImage : !isImage;
+    }
+
+    /**
+     * @brief 展开一个输入参数：文件直接加入，目录按需递归枚举
+     */
+    void collect(mode m, const QString& arg, bool recursive, std::vector<input_item>& items) {
+        const QFileInfo info(arg);
+        if (info.isFile()) {
+            if (accepts(m, arg)) {
+                items.push_back({workers::file_part{info.filePath()}, {}});
+            }
+            return;
+        }
+        if (!info.isDir()) {
+            spdlog::warn("忽略不存在的输入: {}", arg.toStdString());
+            return;
+        }
+
+        const QDir root(info.absoluteFilePath());
+        QDirIterator it(root.absolutePath(), QDir::Files | QDir::NoDotAndDotDot,
+            recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+        while (it.hasNext()) {
+            const QString path = it.next();
+            if (!accepts(m, path)) {
+                continue;
+            }
+            items.push_back({workers::file_part{path}, root.relativeFilePath(it.fileInfo().absolutePath())});
+        }
+    }
+
+    /**
+     * @brief 一个结果的写出情况
+     */
+    struct written_entry {
+        bool held = false; /**< 解码得到的分片已交给 assembler，同组到齐后才写出 */
+        bool ok   = false;
+        QString dest;
+    };
+
+    /**
+     * @brief 处理单个输入并立即写出结果，不在内存中保留任何结果
+     */
+    struct stream_job {
+        mode m;
+        workers::generate_file_worker encoder;
+        workers::decode_file_worker decoder;
+        std::optional<workers::decode_sheet_worker> sheetDecoder; /**< 设置时整页识别，一张图片可能写出多个文件 */
+        workers::save_worker saver;                               /**< 生成时按 --image-format 写出图片 */
+        QDir outputDir;
+        batch_stats* stats;
+        convert::sequence_assembler* assembler; /**< 解码时收集分片，凑齐一组才写出 */
+        workers::batch_journal* journal;        /**< 可选的续跑日志，为空时不记录 */
+
+        void operator()(const input_item& item) const {
+            const QString& path = item.part.path;
+            stats->inputBytes += static_cast<std::uint64_t>(item.part.length >= 0 ? item.part.length : QFileInfo(path).size());
+
+            // 大小、修改时间和摘要都在处理之前取得，处理期间文件被改时续跑会重新核对
+            workers::batch_journal::input_stamp stamp;
+            std::string inputHash;
+            if (journal) {
+                stamp     = workers::batch_journal::input_stamp::of(path);
+                inputHash = workers::batch_journal::hash_file(path, item.part.offset, item.part.length);
+            }
+
+            written_entry summary{.ok = true};
+            const auto track = [&](written_entry written) {
+                summary.held = summary.held || written.held;
+                summary.ok   = summary.ok && written.ok;
+                if (!written.dest.isEmpty()) {
+                    summary.dest = std::move(written.dest);
+                }
+            };
+            if (m == mode::encode) {
+                track(write_entry(item, encoder(item.part)));
+            } else if (sheetDecoder) {
+                for (auto& entry : (*sheetDecoder)(path)) {
+                    track(write_entry(item, std::move(entry)));
+                }
+            } else {
+                track(write_entry(item, decoder(path)));
+            }
+
+            // 交给 assembler 的分片要等整组写出，中途中断后必须重新识别，所以不记录
+            if (journal && !summary.held) {
+                journal->append(workers::batch_journal::make_record(path, item.part.sequence.index, item.part.sequence.total,
+                    stamp, std::move(inputHash), summary.dest, summary.ok));
+            }
+
+            if (const auto done = ++stats->done; done % 1000 == 0) {
+                spdlog::info("已处理 {} 个文件", done);
+            }
+        }
+
+    private:
+        written_entry write_entry(const input_item& item, convert::result_data_entry entry) const {
+            written_entry written;
+            if (m == mode::decode && entry && entry.sequence.total > 1) {
+                auto merged = assembler->add(std::move(entry));
+                if (!merged) {
+                    // 分片已收下，等同组其余分片到齐后再写出并计入成功数
+                    written.held = true;
+                    written.ok   = true;
+                    return written;
+                }
+                // 凑齐的这一组中其它分片来自别的输入，它们都没有记录，这一项也按未完成处理；
+                // 分片总数与同组不一致时 add 返回错误条目，下面照常计为失败
+                written.held = true;
+                entry        = std::move(*merged);
+            }
+
+            bool ok = false;
+            if (entry) {
+                const QString dir = item.relativeDir.isEmpty() || item.relativeDir == "."
+                    ? outputDir.absolutePath()
+                    : outputDir.absoluteFilePath(item.relativeDir);
+                QDir().mkpath(dir);
+
+                const QString dest = QDir(dir).filePath(entry.get_default_target_name(saver.image.suffix()));
+                const auto saved = saver({entry, dest});
+                ok = saved.err == workers::save_result::success;
+                if (ok) {
+                    stats->outputBytes += static_cast<std::uint64_t>(QFileInfo(dest).size());
+                    written.dest = dest;
+                } else {
+                    spdlog::warn("{}: 写入失败 {}", item.part.path.toStdString(), dest.toStdString());
+                }
+            } else if (const auto* err = std::get_if<std::string>(&entry.data)) {
+                spdlog::warn("{}: {}", entry.source_file_name.toStdString(), *err);
+            }
+
+            ++(ok ? stats->succeeded : stats->failed);
+            written.ok = ok;
+            return written;
+        }
+    };
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("Lab2QRCode-cli");
+    QCoreApplication::setApplicationVersion(QString::fromUtf8(version::git_tag.data(), static_cast<int>(version::git_tag.size())));
+
+    // 日志走 stderr，stdout 只输出统计结果，方便脚本解析
+    spdlog::set_default_logger(spdlog::stderr_color_mt("cli"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Lab2QRCode 无界面批处理：将文件批量生成条码图片，或将条码图片批量解码为文件");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("mode", "encode 或 decode");
+    parser.addPositionalArgument("inputs", "输入文件或目录，\"-\" 表示从标准输入逐行读取路径", "[inputs...]");
+
+    const QCommandLineOption outputOption({"o", "output"}, "输出目录（默认当前目录）", "dir", ".");
+    const QCommandLineOption formatOption({"f", "format"}, "条码格式（生成默认 QRCode；解码时指定则优先只识别该格式）", "format", "QRCode");
+    const QCommandLineOption widthOption("width", "图片宽度（默认 300）", "px", "300");
+    const QCommandLineOption heightOption("height", "图片高度（默认 300）", "px", "300");
+    const QCommandLineOption noBase64Option("no-base64", "不使用 Base64 编码/解码");
+    const QCommandLineOption packingOption("packing", "Base64 模式下的文本编码：auto（默认，QR 系列用 Base45）、base64 或 base45", "name", "auto");
+    const QCommandLineOption binaryOption("binary", "原始字节模式：不经 Base64，直接写入条码的字节模式（仅二维码格式）");
+    const QCommandLineOption noCompressOption("no-compress", "生成时不压缩（默认在 Base64/原始字节之前尝试压缩，不变小时自动跳过）");
+    const QCommandLineOption effortOption("effort", "识别强度：fast、balanced（默认，失败后以 thorough 再试一次）或 thorough", "level", "balanced");
+    const QCommandLineOption strictFormatOption("strict-format", "解码只识别 --format 指定的格式，失败不再尝试其它格式");
+    const QCommandLineOption sheetOption("sheet", "整页识别：解码图片中的全部条码，大图分块并行");
+    const QCommandLineOption imageFormatOption("image-format", "生成图片的保存格式：png1（默认，1 位 PNG）、png（8 位灰度）、pbm 或 modules（模块矩阵 PBM）", "format", "png1");
+    const QCommandLineOption pngLevelOption("png-level", "1 位 PNG 的 zlib 压缩等级 0~9（默认 6）", "level", "6");
+    const QCommandLineOption recursiveOption({"r", "recursive"}, "递归处理子目录");
+    const QCommandLineOption jobsOption({"j", "jobs"}, "并发线程数（默认 CPU 核心数）", "n");
+    const QCommandLineOption cacheDirOption("cache-dir", "条码磁盘缓存目录，跨次运行复用已生成的图片", "dir");
+    const QCommandLineOption cacheDiskOption("cache-disk", "条码磁盘缓存容量（MiB，默认 1024，0 表示不限），超出后删除最旧的文件", "mb", "1024");
+    const QCommandLineOption cacheMemoryOption("cache-memory", "条码内存缓存容量（MiB，默认 256，0 表示关闭）", "mb", "256");
+    const QCommandLineOption noDedupOption("no-dedup", "生成时不对内容相同的文件去重（默认同一内容只编码一次）");
+    const QCommandLineOption journalOption("journal", "续跑日志：记录已完成的文件，以相同参数再次运行时跳过它们", "file");
+    parser.addOptions({outputOption, formatOption, widthOption, heightOption, noBase64Option, packingOption, binaryOption, noCompressOption, effortOption,
+        strictFormatOption, sheetOption, imageFormatOption, pngLevelOption, recursiveOption, jobsOption, cacheDirOption, cacheDiskOption, cacheMemoryOption,
+        noDedupOption, journalOption});
+
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.size() < 2 || (args[0] != "encode" && args[0] != "decode")) {
+        std::fputs(qPrintable(parser.helpText()), stderr);
+        return 2;
+    }
+    const mode m = args[0] == "encode" ? mode::encode : mode::decode;
+
+    const auto format = ZXing::BarcodeFormatFromString(parser.value(formatOption).toStdString());
+    if (format == ZXing::BarcodeFormat::None) {
+        spdlog::error("未知的条码格式: {}", parser.value(formatOption).toStdString());
+        return 2;
+    }
+
+    const auto packing = convert::text_packing_from_string(parser.value(packingOption).toStdString());
+    if (!packing) {
+        spdlog::error("未知的文本编码: {}", parser.value(packingOption).toStdString());
+        return 2;
+    }
+
+    const auto imageFormat = convert::image_save_options::format_from_string(parser.value(imageFormatOption).toStdString());
+    if (!imageFormat) {
+        spdlog::error("未知的图片格式: {}", parser.value(imageFormatOption).toStdString());
+        return 2;
+    }
+    const convert::image_save_options saveOptions{
+        .format    = *imageFormat,
+        .png_level = std::clamp(parser.value(pngLevelOption).toInt(), -1, 9),
+    };
+
+    const auto effort = convert::decode_profile::effort_from_string(parser.value(effortOption).toStdString());
+    if (!effort) {
+        spdlog::error("未知的识别强度: {}", parser.value(effortOption).toStdString());
+        return 2;
+    }
+    // 解码默认识别全部格式，只有显式指定 --format 时才限定
+    const convert::decode_profile profile{
+        .formats              = parser.isSet(formatOption) ? ZXing::BarcodeFormats(format) : ZXing::BarcodeFormats{},
+        .effort               = *effort,
+        .fallback_all_formats = !parser.isSet(strictFormatOption),
+    };
+
+    if (parser.isSet(jobsOption)) {
+        QThreadPool::globalInstance()->setMaxThreadCount(std::max(1, parser.value(jobsOption).toInt()));
+    }
+
+    const QDir outputDir(parser.value(outputOption));
+    if (!QDir().mkpath(outputDir.absolutePath())) {
+        spdlog::error("无法创建输出目录: {}", outputDir.absolutePath().toStdString());
+        return 2;
+    }
+
+    batch_stats stats;
+    std::vector<input_item> items;
+    const bool recursive = parser.isSet(recursiveOption);
+    for (const QString& arg : args.mid(1)) {
+        if (arg == "-") {
+            for (std::string line; std::getline(std::cin, line);) {
+                if (!line.empty()) {
+                    collect(m, QString::fromStdString(line).trimmed(), recursive, items);
+                }
+            }
+        } else {
+            collect(m, arg, recursive, items);
+        }
+    }
+    if (items.empty()) {
+        spdlog::error("无可处理文件");
+        return 2;
+    }
+
+    const bool useBase64 = !parser.isSet(noBase64Option);
+    // 不支持字节模式的格式忽略 --binary，分片规划与生成保持一致
+    const bool binary    = parser.isSet(binaryOption) && convert::supports_binary(format);
+
+    // 影响输出的参数都计入指纹，任何一项不同都视为另一批任务
+    std::optional<workers::batch_journal> journal;
+    if (parser.isSet(journalOption)) {
+        const QStringList settings{args[0], parser.value(formatOption), parser.value(widthOption), parser.value(heightOption),
+            QString::number(useBase64), parser.value(packingOption), QString::number(binary),
+            QString::number(!parser.isSet(noCompressOption)), parser.value(effortOption), QString::number(parser.isSet(strictFormatOption)),
+            QString::number(parser.isSet(sheetOption)), QString::number(static_cast<int>(saveOptions.format)),
+            QString::number(saveOptions.png_level), outputDir.absolutePath()};
+        journal.emplace();
+        if (!journal->open(parser.value(journalOption), settings.join(';').toStdString())) {
+            return 2;
+        }
+    }
+
+    // 超出单个条码容量的文件展开为多个分片任务；日志中已完成的分片跳过
+    std::vector<input_item> planned;
+    planned.reserve(items.size());
+    for (const auto& item : items) {
+        auto parts = m == mode::encode ? workers::plan_file_parts(item.part.path, format, useBase64, binary, *packing)
+                                       : QList<workers::file_part>{item.part};
+        if (journal) {
+            parts = workers::journal_pending(*journal, parts);
+            if (parts.isEmpty()) {
+                ++stats.skipped;
+                continue;
+            }
+        }
+        for (auto& part : parts) {
+            planned.push_back({std::move(part), item.relativeDir});
+        }
+    }
+    items = std::move(planned);
+
+    convert::barcode_cache cache({
+        .memory_bytes = static_cast<std::size_t>(std::max(0, parser.value(cacheMemoryOption).toInt())) * 1024 * 1024,
+        .disk_dir     = parser.value(cacheDirOption),
+        .disk_bytes   = static_cast<std::uint64_t>(std::max(0, parser.value(cacheDiskOption).toInt())) * 1024 * 1024,
+    });
+
+    convert::sequence_assembler assembler;
+    // 内容相同的整文件只编码一次，结果按各自的文件名写出
+    const auto dedup = parser.isSet(noDedupOption) ? nullptr : std::make_shared<workers::batch_dedup<convert::result_data_entry>>();
+    const stream_job job{
+        m,
+        workers::generate_file_worker{
+            parser.value(widthOption).toInt(), parser.value(heightOption).toInt(), useBase64, format, &cache,
+            !parser.isSet(noCompressOption), binary, *packing, 0, dedup},
+        workers::decode_file_worker{useBase64, profile},
+        parser.isSet(sheetOption) ? std::optional{workers::decode_sheet_worker{useBase64, profile}} : std::nullopt,
+        workers::save_worker{saveOptions, journal.has_value()},
+        outputDir,
+        &stats,
+        &assembler,
+        journal ? &*journal : nullptr,
+    };
+
+    spdlog::info("开始{}: {} 个文件，跳过 {} 个，{} 个线程", m == mode::encode ? "生成" : "解码", items.size(), stats.skipped.load(),
+        QThreadPool::globalInstance()->maxThreadCount());
+
+    QElapsedTimer timer;
+    timer.start();
+    QtConcurrent::blockingMap(items, job);
+    const double seconds = std::max(timer.nsecsElapsed() / 1e9, 1e-9);
+    if (m == mode::encode) {
+        cache.logStats();
+        if (dedup) {
+            dedup->logStats();
+        }
+    }
+    for (const auto& incomplete : assembler.take_incomplete()) {
+        spdlog::warn("{}: {}", incomplete.source_file_name.toStdString(), std::get<std::string>(incomplete.data));
+        ++stats.failed;
+    }
+
+    constexpr double MiB = 1024.0 * 1024.0;
+    std::printf("files:        %llu\n", static_cast<unsigned long long>(stats.done.load()));
+    std::printf("succeeded:    %llu\n", static_cast<unsigned long long>(stats.succeeded.load()));
+    std::printf("failed:       %llu\n", static_cast<unsigned long long>(stats.failed.load()));
+    std::printf("skipped:      %llu\n", static_cast<unsigned long long>(stats.skipped.load()));
+    if (m == mode::encode && dedup) {
+        const auto deduped = dedup->stats();
+        std::printf("duplicates:   %llu (%llu distinct, %.2f MiB not re-encoded)\n", static_cast<unsigned long long>(deduped.duplicates),
+            static_cast<unsigned long long>(deduped.distinct()), deduped.saved_bytes / (1024.0 * 1024.0));
+    }
+    std::printf("elapsed:      %.3f s\n", seconds);
+    std::printf("throughput:   %.1f files/s\n", stats.done.load() / seconds);
+    std::printf("input:        %.2f MiB (%.2f MiB/s)\n", stats.inputBytes.load() / MiB, stats.inputBytes.load() / MiB / seconds);
+    std::printf("output:       %.2f MiB (%.2f MiB/s)\n", stats.outputBytes.load() / MiB, stats.outputBytes.load() / MiB / seconds);
+    std::printf("peak rss:     %.2f MiB\n", sysinfo::getPeakRSS<sysinfo::MB>());
+
+    // 各阶段耗时是全部线程之和；日志中同时输出一行 JSON，便于收集
+    const auto timings = timing::stage_timings::global().summarize();
+    spdlog::info("stage_timings {}", nlohmann::json{{"elapsed_ms", seconds * 1e3}, {"stages", timing::to_json(timings)}}.dump());
+    for (const auto& s : timings) {
+        const std::string key = std::string(timing::stage_key(s.s)) + ":";
+        std::printf("stage %-14s %8llu calls, total %10.1f ms, p50 %9.1f us, p90 %9.1f us, p99 %9.1f us, max %9.1f us\n",
+            key.c_str(), static_cast<unsigned long long>(s.count), s.total / 1e6, s.p50 / 1e3, s.p90 / 1e3, s.p99 / 1e3, s.max / 1e3);
+    }
+
+    return stats.failed.load() == 0 ? 0 : 1;
+}
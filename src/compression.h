@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include <QByteArray>
+
+/**
+ * @file compression.h
+ * @brief 生成前的可选压缩，以及解码后的透明解压
+ *
+ * 压缩后的负载以一个 5 字节的头开始：
+ *
+ *     \x1F L 2 Z <codec>
+ *
+ * 头位于 Base64 之内（压缩结果是二进制数据，只在 Base64 模式下启用）。
+ * 不带头的负载按原始数据处理，旧版本生成的条码可以照常解码。
+ * 解码时会对可压缩模式的负载检查压缩头，所以即使不压缩，恰好以魔数开头的原始数据也要加 stored 头（escape_payload）。
+ */
+namespace convert {
+
+    inline constexpr std::string_view compression_magic = "\x1FL2Z";
+
+    /**
+     * @brief 压缩头的长度（魔数 + codec 字节）
+     */
+    inline constexpr std::size_t compression_header_size = compression_magic.size() + 1;
+
+    /**
+     * @brief 解压后大小的上限倍数：deflate 的压缩比不超过约 1032:1，声明的原始长度超出时视为数据损坏
+     *
+     * qUncompress 按前 4 字节声明的长度一次性分配缓冲区，不加限制时一个损坏或伪造的条码就能要求分配近 2 GiB。
+     */
+    inline constexpr std::size_t max_inflate_ratio = 1032;
+
+    enum class payload_codec : std::uint8_t {
+        stored = 0, /**< 未压缩，仅用于原始数据恰好以魔数开头的情况 */
+        zlib   = 1, /**< qCompress 格式：4 字节大端原始长度 + zlib 流 */
+    };
+
+    /**
+     * @brief 判断数据是否以压缩头开始
+     */
+    [[nodiscard]] inline bool has_compression_header(std::span<const std::uint8_t> data) {
+        return data.size() >= compression_header_size
+            && std::memcmp(data.data(), compression_magic.data(), compression_magic.size()) == 0;
+    }
+
+    /**
+     * @brief 不压缩时的转义：原始数据恰好以魔数开头时加一个 stored 头，避免解码时被误认为压缩数据
+     * @return 带 stored 头的数据；不需要转义时返回 std::nullopt，调用方原样使用 raw
+     */
+    [[nodiscard]] inline std::optional<QByteArray> escape_payload(std::span<const std::uint8_t> raw) {
+        if (!has_compression_header(raw)) {
+            return std::nullopt;
+        }
+        QByteArray packed;
+        packed.reserve(static_cast<int>(compression_header_size + raw.size()));
+        packed.append(compression_magic.data(), static_cast<int>(compression_magic.size()));
+        packed.append(static_cast<char>(payload_codec::stored));
+        packed.append(reinterpret_cast<const char*>(raw.data()), static_cast<int>(raw.size()));
+        return packed;
+    }
+
+    /**
+     * @brief 尝试压缩负载
+     * @param raw 原始负载
+     * @param level zlib 压缩等级，-1 为默认
+     * @return 带压缩头的数据；压缩后不比原始数据小时返回 std::nullopt，调用方原样使用 raw
+     */
+    [[nodiscard]] inline std::optional<QByteArray> compress_payload(std::span<const std::uint8_t> raw, int level = -1) {
+        QByteArray packed;
+        if (!raw.empty()) {
+            const QByteArray compressed = qCompress(raw.data(), static_cast<int>(raw.size()), level);
+            if (compression_header_size + static_cast<std::size_t>(compressed.size()) < raw.size()) {
+                packed.reserve(static_cast<int>(compression_header_size) + compressed.size());
+                packed.append(compression_magic.data(), static_cast<int>(compression_magic.size()));
+                packed.append(static_cast<char>(payload_codec::zlib));
+                packed.append(compressed);
+                return packed;
+            }
+        }
+
+        return escape_payload(raw);
+    }
+
+    /**
+     * @brief 识别压缩头并就地解压，不带压缩头的数据保持不变
+     * @return 数据带有压缩头但无法解压（未知 codec 或数据损坏）时返回 false
+     */
+    [[nodiscard]] inline bool decompress_payload(QByteArray& data) {
+        const std::span<const std::uint8_t> bytes{
+            reinterpret_cast<const std::uint8_t*>(data.constData()), static_cast<std::size_t>(data.size())};
+        if (!has_compression_header(bytes)) {
+            return true;
+        }
+
+        const auto codec = static_cast<payload_codec>(bytes[compression_magic.size()]);
+        const auto body  = bytes.subspan(compression_header_size);
+        switch (codec) {
+        case payload_codec::stored:
+            data.remove(0, static_cast<int>(compression_header_size));
+            return true;
+        case payload_codec::zlib: {
+            // qCompress 格式的前 4 字节是大端的原始长度
+            if (body.size() < 4) {
+                return false;
+            }
+            const std::size_t declared = (std::size_t{body[0]} << 24) | (std::size_t{body[1]} << 16) | (std::size_t{body[2]} << 8) | body[3];
+            if (declared > (body.size() - 4) * max_inflate_ratio) {
+                return false;
+            }
+            QByteArray raw = qUncompress(body.data(), static_cast<int>(body.size()));
+            if (raw.isEmpty()) {
+                return false;
+            }
+            data = std::move(raw);
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+} // namespace convert
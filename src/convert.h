@@ -5,41 +5,189 @@
 #ifndef LAB2QRCODE_CONVERT_H
 #define LAB2QRCODE_CONVERT_H
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
+#include <QBuffer>
 #include <QImage>
+#include <QImageReader>
 #include <QString>
 #include <QFileInfo>
+#include <QDir>
 #include <QByteArray>
 #include <ZXing/BitMatrix.h>
+#include <ZXing/CharacterSet.h>
 #include <ZXing/ImageView.h>
 #include <ZXing/MultiFormatWriter.h>
 #include <ZXing/ReadBarcode.h>
 #include <opencv2/opencv.hpp>
 
+#include "image_writer.h"
+#include "stage_timing.h"
+
 /**
  * @namespace convert
  * @brief 提供二维码生成和解析的转换功能（摄像头识别与此无关）
  */
 namespace convert{
+    /**
+     * @brief 多条码分片信息，见 sequence.h
+     */
+    struct sequence_info {
+        std::uint32_t id = 0; /**< 分组 id，同一文件的所有分片相同 */
+        int index = 0;        /**< 分片序号，从 0 开始 */
+        int total = 0;        /**< 分片总数，0 表示不是分片 */
+    };
+
+    struct QRcode_create_config{
+        int target_width = 300;
+        int target_height = 300;
+        ZXing::BarcodeFormat format = ZXing::BarcodeFormat::QRCode;
+        int margin = 1;
+    };
+
+    /**
+     * @brief 生成结果的紧凑形式：1:1 的模块矩阵（每模块 1 位）加光栅化参数
+     *
+     * 300x300 的灰度图约 88KB，而同一个 57x57 模块的 QR 码矩阵只有约 400 字节。
+     * 结果中只保存矩阵，显示或保存时才调用 render 光栅化，换尺寸重新渲染也不必再经过 ZXing。
+     */
+    struct module_matrix {
+        int columns = 0;                /**< 每行模块数 */
+        int rows    = 0;                /**< 模块行数，一维码为 1 */
+        std::vector<std::uint8_t> bits; /**< 按行打包，每行 stride() 字节，最高位在前，1 为黑 */
+        QRcode_create_config config;    /**< 光栅化参数 */
+
+        [[nodiscard]] module_matrix() = default;
+
+        /**
+         * @param modules 未放大的模块矩阵
+         * @param config 光栅化参数
+         */
+        [[nodiscard]] module_matrix(const ZXing::BitMatrix& modules, const QRcode_create_config& config) :
+            columns(modules.width()), rows(modules.height()), config(config) {
+            bits.assign(static_cast<std::size_t>(stride()) * std::max(rows, 0), 0);
+            for (int y = 0; y < rows; ++y) {
+                for (int x = 0; x < columns; ++x) {
+                    if (modules.get(x, y))
+                        set(x, y);
+                }
+            }
+        }
+
+        [[nodiscard]] int width() const noexcept { return columns; }
+        [[nodiscard]] int height() const noexcept { return rows; }
+        [[nodiscard]] int stride() const noexcept { return (columns + 7) / 8; }
+        [[nodiscard]] bool empty() const noexcept { return columns <= 0 || rows <= 0; }
+
+        [[nodiscard]] bool get(int x, int y) const noexcept {
+            return bits[static_cast<std::size_t>(y) * stride() + x / 8] >> (7 - x % 8) & 1;
+        }
+
+        void set(int x, int y) noexcept {
+            bits[static_cast<std::size_t>(y) * stride() + x / 8] |= static_cast<std::uint8_t>(0x80 >> (x % 8));
+        }
+
+        /**
+         * @brief 占用的内存（字节），供缓存按容量淘汰
+         */
+        [[nodiscard]] std::size_t byte_size() const noexcept { return sizeof(*this) + bits.capacity(); }
+
+        /**
+         * @brief 按 config 中的尺寸光栅化
+         */
+        [[nodiscard]] QImage render() const;
+
+        /**
+         * @brief 按指定尺寸光栅化（留白与 config 相同），条码本身更大时按条码实际尺寸输出
+         */
+        [[nodiscard]] QImage render(int target_width, int target_height) const;
+
+        /**
+         * @brief 不超过 size x size 的缩略图，直接按缩略图尺寸光栅化，不经过整图缩放
+         *
+         * 条码能以整数倍放进 size 时只有黑白两色，存为 1 位图；模块数超过 size 时才缩小为灰度图。
+         */
+        [[nodiscard]] QImage thumbnail(int size) const {
+            const QImage image = render(size, size);
+            if (image.width() <= size && image.height() <= size)
+                return image.convertToFormat(QImage::Format_Mono, Qt::ThresholdDither);
+            return image.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        }
+
+        /**
+         * @brief 每个模块一个像素、不含留白的灰度图，带有 1:1 的模块网格，可直接按 image_format::modules 保存
+         */
+        [[nodiscard]] QImage module_image() const {
+            QImage image(columns, rows, QImage::Format_Grayscale8);
+            for (int y = 0; y < rows; ++y) {
+                uchar* line = image.scanLine(y);
+                for (int x = 0; x < columns; ++x) {
+                    line[x] = get(x, y) ? 0x00 : 0xFF;
+                }
+            }
+            module_geometry{0, 0, columns, rows, 1, 1}.store(image);
+            return image;
+        }
+
+        /**
+         * @brief module_image 的逆过程，灰度小于 128 的像素为黑
+         */
+        [[nodiscard]] static module_matrix from_module_image(const QImage& image, const QRcode_create_config& config) {
+            const QImage gray = image.format() == QImage::Format_Grayscale8 ? image : image.convertToFormat(QImage::Format_Grayscale8);
+            module_matrix m;
+            m.columns = gray.width();
+            m.rows    = gray.height();
+            m.config  = config;
+            m.bits.assign(static_cast<std::size_t>(m.stride()) * m.rows, 0);
+            for (int y = 0; y < m.rows; ++y) {
+                const uchar* line = gray.constScanLine(y);
+                for (int x = 0; x < m.columns; ++x) {
+                    if (line[x] < 0x80)
+                        m.set(x, y);
+                }
+            }
+            return m;
+        }
+    };
+
     struct result_data_entry {
-        using variant_t = std::variant<std::monostate, QImage, QByteArray, std::string>;
+        using variant_t = std::variant<std::monostate, QImage, QByteArray, std::string, module_matrix>;
 
-        //Empty, QRCode, decoded text, error
+        //Empty, QRCode, decoded text, error, QRCode modules (rendered on demand)
         QString source_file_name;
         variant_t data;
+        sequence_info sequence{};
+        QString saved_path; /**< 非空表示生成后已直接写入该路径，data 为空图，只保留 thumbnail */
+        QImage thumbnail;   /**< 工作线程生成的缩略图，界面直接显示，不再在界面线程缩放整图；可能为空 */
+        QString relative_dir; /**< 输入来自目录枚举时相对于枚举根目录的子目录，保存时在输出目录中保持层级；否则为空 */
 
         [[nodiscard]] result_data_entry() = default;
 
         [[nodiscard]] result_data_entry(const QString& source_file_name, const variant_t& data) :
             source_file_name(source_file_name), data(data) {}
 
-        [[nodiscard]] QString get_default_target_name() const {
-            if (std::holds_alternative<QImage>(data)) {
+        /**
+         * @param imageSuffix 图片的扩展名（不含点），随保存格式变化，见 image_save_options::suffix
+         */
+        [[nodiscard]] QString get_default_target_name(const QString& imageSuffix = "png") const {
+            if (std::holds_alternative<QImage>(data) || std::holds_alternative<module_matrix>(data)) {
+                if (sequence.total > 1) {
+                    // 分片按 "_序号" 区分，避免互相覆盖
+                    const QString base = source_file_name.isEmpty() ? "qrcode" : QFileInfo(source_file_name).baseName();
+                    return QString("%1_%2.%3").arg(base).arg(sequence.index + 1).arg(imageSuffix);
+                }
                 if (!source_file_name.isEmpty())
-                    return QFileInfo(source_file_name).baseName() + ".png";
-                return "qrcode.png";
+                    return QFileInfo(source_file_name).baseName() + "." + imageSuffix;
+                return "qrcode." + imageSuffix;
             }
             if (std::holds_alternative<QByteArray>(data)) {
 
@@ -51,6 +199,14 @@ namespace convert{
             return {};
         }
 
+        /**
+         * @brief 在输出目录中的相对路径：relative_dir 下的 get_default_target_name，不同子目录中的同名文件不会互相覆盖
+         */
+        [[nodiscard]] QString get_default_target_path(const QString& imageSuffix = "png") const {
+            const QString name = get_default_target_name(imageSuffix);
+            return relative_dir.isEmpty() || name.isEmpty() ? name : QDir(relative_dir).filePath(name);
+        }
+
         template <typename Str, typename T>
             requires (std::constructible_from<variant_t, T&&> && std::constructible_from<QString, Str&&>)
         [[nodiscard]] explicit(!std::convertible_to<T&&, variant_t>)
@@ -69,38 +225,346 @@ namespace convert{
             data.emplace<std::string>(err.toStdString());
         }
 
+        /**
+         * @brief 结果对应的图片：QImage 原样返回，模块矩阵此时才光栅化；其它类型返回空图
+         */
+        [[nodiscard]] QImage image() const {
+            if (const auto* img = std::get_if<QImage>(&data))
+                return *img;
+            if (const auto* modules = std::get_if<module_matrix>(&data))
+                return modules->render();
+            return {};
+        }
+
         explicit operator bool() const noexcept {
             return !std::holds_alternative<std::monostate>(data) && !std::holds_alternative<std::string>(data);;
         }
     };
 
-    struct QRcode_create_config{
-        int target_width = 300;
-        int target_height = 300;
-        ZXing::BarcodeFormat format = ZXing::BarcodeFormat::QRCode;
-        int margin = 1;
+    /**
+     * @brief 负载写入条码的方式
+     */
+    enum class payload_mode {
+        text,         /**< UTF-8 文本原样写入 */
+        base64,       /**< 先 Base64 编码，条码中只有 ASCII 字符 */
+        binary,       /**< 原始字节直接写入条码的字节模式，不经过文本转换 */
+        base45,       /**< base45_marker 之后为 Base45 编码，QR 码中走字母数字模式 */
+        alphanumeric, /**< alphanumeric_marker 之后为原样写入的负载，负载本身只含字母数字模式的字符 */
     };
 
-    [[nodiscard]] inline QImage byte_to_QRCode_qimage(const std::string& text, const QRcode_create_config qrcode_config){
-        ZXing::MultiFormatWriter writer(qrcode_config.format);
-        writer.setMargin(qrcode_config.margin);
+    /**
+     * @brief 勾选 Base64 时把字节转成文本的方式
+     */
+    enum class text_packing {
+        automatic, /**< 按格式选择：QR 系列用 Base45，负载本身只含字母数字模式字符时原样写入；其它格式用 Base64 */
+        base64,
+        base45,
+    };
+
+    /**
+     * @brief Base45 负载的标记，不属于 Base64 字母表，旧版本生成的 Base64 条码不会以它开头
+     */
+    inline constexpr char base45_marker = '%';
+
+    /**
+     * @brief 原样写入的字母数字负载的标记
+     */
+    inline constexpr char alphanumeric_marker = ':';
+
+    /**
+     * @brief 解析 "auto" / "base64" / "base45"，无法识别时返回 std::nullopt
+     */
+    [[nodiscard]] inline std::optional<text_packing> text_packing_from_string(std::string_view name) {
+        if (name == "auto")
+            return text_packing::automatic;
+        if (name == "base64")
+            return text_packing::base64;
+        if (name == "base45")
+            return text_packing::base45;
+        return std::nullopt;
+    }
+
+    /**
+     * @brief 该格式是否有字母数字模式（数字、大写字母和 " $%*+-./:"，每字符 5.5 位）
+     */
+    [[nodiscard]] inline bool supports_alphanumeric(ZXing::BarcodeFormat format) {
+        return format == ZXing::BarcodeFormat::QRCode || format == ZXing::BarcodeFormat::MicroQRCode
+            || format == ZXing::BarcodeFormat::RMQRCode;
+    }
+
+    /**
+     * @brief 数据是否只含 QR 码字母数字模式的字符
+     */
+    [[nodiscard]] inline bool is_alphanumeric(std::span<const std::uint8_t> data) {
+        return std::ranges::all_of(data, [](std::uint8_t c) {
+            return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || std::string_view(" $%*+-./:").find(static_cast<char>(c)) != std::string_view::npos;
+        });
+    }
+
+    /**
+     * @brief 该格式能否以字节模式写入任意字节（仅 QR 系列）
+     *
+     * DataMatrix、Aztec、PDF417 的编码器对 CharacterSet::BINARY 和二进制 ECI 的处理未经往返验证，
+     * 这些格式仍按文本或 Base64 写入。
+     */
+    [[nodiscard]] inline bool supports_binary(ZXing::BarcodeFormat format) {
+        switch (format) {
+        case ZXing::BarcodeFormat::QRCode:
+        case ZXing::BarcodeFormat::MicroQRCode:
+        case ZXing::BarcodeFormat::RMQRCode:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    /**
+     * @brief 将条码的模块矩阵按整数倍放大，光栅化为灰度图
+     *
+     * 与 ZXing 自带的 Inflate / RenderResult 的尺寸规则保持一致（居中、整数倍缩放、margin 以像素计），
+     * 但按模块游程整段 memset，并直接复制同一模块行内重复的扫描线，不再逐像素调用 BitMatrix::get。
+     *
+     * @param modules 未放大的模块矩阵（一维码只有一行），ZXing::BitMatrix 或 module_matrix
+     * @param target_width 期望宽度，小于条码本身时按条码实际尺寸输出
+     * @param target_height 期望高度
+     * @param margin 留白像素数
+     */
+    template <typename Matrix>
+    [[nodiscard]] QImage rasterize_modules(const Matrix& modules, int target_width, int target_height, int margin){
+        constexpr uchar black = 0x00;
+        constexpr uchar white = std::numeric_limits<uchar>::max();
+
+        const int codeWidth  = modules.width();
+        const int codeHeight = modules.height();
+        if (codeWidth <= 0 || codeHeight <= 0) {
+            return {};
+        }
 
-        const auto bitMatrix = writer.encode(text, qrcode_config.target_width, qrcode_config.target_height);
-        const auto width = bitMatrix.width();
-        const auto height = bitMatrix.height();
+        int width, height, scaleX, scaleY, left, top;
+        if (codeHeight == 1) {
+            // 一维码：横向整数倍放大，纵向拉满整个高度
+            const int fullWidth = codeWidth + margin;
+            width  = std::max(target_width, fullWidth);
+            height = std::max(1, target_height);
+            scaleX = width / fullWidth;
+            scaleY = height;
+            left   = (width - codeWidth * scaleX) / 2;
+            top    = 0;
+        } else {
+            width  = std::max(target_width, codeWidth + 2 * margin);
+            height = std::max(target_height, codeHeight + 2 * margin);
+            scaleX = scaleY = std::min((width - 2 * margin) / codeWidth, (height - 2 * margin) / codeHeight);
+            left   = (width - codeWidth * scaleX) / 2;
+            top    = (height - codeHeight * scaleY) / 2;
+        }
 
         QImage image(width, height, QImage::Format_Grayscale8);
+        const int right = width - left - codeWidth * scaleX;
+        // 记录模块网格，保存为模块矩阵时按它取样
+        module_geometry{left, top, codeWidth, codeHeight, scaleX, scaleY}.store(image);
+
+        for (int y = 0; y < top; ++y) {
+            std::memset(image.scanLine(y), white, width);
+        }
+
+        for (int my = 0; my < codeHeight; ++my) {
+            const int y0 = top + my * scaleY;
+            uchar* line  = image.scanLine(y0);
+
+            std::memset(line, white, left);
+            uchar* out = line + left;
+            for (int mx = 0; mx < codeWidth;) {
+                const bool set = modules.get(mx, my);
+                int end        = mx + 1;
+                while (end < codeWidth && modules.get(end, my) == set) {
+                    ++end;
+                }
+                std::memset(out, set ? black : white, static_cast<std::size_t>(end - mx) * scaleX);
+                out += static_cast<std::ptrdiff_t>(end - mx) * scaleX;
+                mx   = end;
+            }
+            std::memset(out, white, right);
 
-        for (int y = 0; y < height; ++y) {
-            uchar* line = image.scanLine(y);
-            for (int x = 0; x < width; ++x) {
-                line[x] = bitMatrix.get(x, y) ? 0x00 : std::numeric_limits<uchar>::max();
+            // 同一模块行放大出来的扫描线完全相同，直接复制
+            for (int k = 1; k < scaleY; ++k) {
+                std::memcpy(image.scanLine(y0 + k), line, width);
             }
         }
 
+        for (int y = top + codeHeight * scaleY; y < height; ++y) {
+            std::memset(image.scanLine(y), white, width);
+        }
+
         return image;
     }
 
+    inline QImage module_matrix::render() const {
+        return render(config.target_width, config.target_height);
+    }
+
+    inline QImage module_matrix::render(int target_width, int target_height) const {
+        return empty() ? QImage{} : rasterize_modules(*this, target_width, target_height, config.margin);
+    }
+
+    /**
+     * @brief 将 UTF-8 字节直接解码追加到宽字符串末尾
+     *
+     * 等价于 ZXing 内部对 std::string 入参做的 FromUtf8，但可以直接读取内存映射的文件内容，
+     * 不必先拷贝出一个 std::string。非法序列替换为 U+FFFD；wchar_t 为 16 位的平台输出代理对。
+     */
+    inline void append_utf8_as_wide(std::wstring& out, std::string_view utf8) {
+        constexpr wchar_t replacement = 0xFFFD;
+        out.reserve(out.size() + utf8.size());
+
+        const auto* p         = reinterpret_cast<const unsigned char*>(utf8.data());
+        const auto* const end = p + utf8.size();
+        while (p < end) {
+            const unsigned char lead = *p;
+            if (lead < 0x80) {
+                out.push_back(static_cast<wchar_t>(lead));
+                ++p;
+                continue;
+            }
+
+            int extra;
+            char32_t cp;
+            if (lead >= 0xC2 && lead <= 0xDF) {
+                extra = 1, cp = lead & 0x1F;
+            } else if ((lead & 0xF0) == 0xE0) {
+                extra = 2, cp = lead & 0x0F;
+            } else if (lead >= 0xF0 && lead <= 0xF4) {
+                extra = 3, cp = lead & 0x07;
+            } else {
+                out.push_back(replacement);
+                ++p;
+                continue;
+            }
+
+            int i = 1;
+            for (; i <= extra && p + i < end && (p[i] & 0xC0) == 0x80; ++i) {
+                cp = (cp << 6) | (p[i] & 0x3F);
+            }
+            const bool overlong = (extra == 2 && cp < 0x800) || (extra == 3 && cp < 0x10000);
+            if (i <= extra || overlong || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+                out.push_back(replacement);
+                p += i;
+                continue;
+            }
+            p += i;
+
+            if constexpr (sizeof(wchar_t) == 2) {
+                if (cp >= 0x10000) {
+                    cp -= 0x10000;
+                    out.push_back(static_cast<wchar_t>(0xD800 + (cp >> 10)));
+                    out.push_back(static_cast<wchar_t>(0xDC00 + (cp & 0x3FF)));
+                    continue;
+                }
+            }
+            out.push_back(static_cast<wchar_t>(cp));
+        }
+    }
+
+    /**
+     * @brief 判断数据是否为合法的 UTF-8（规则与 append_utf8_as_wide 相同）
+     */
+    [[nodiscard]] inline bool is_valid_utf8(std::span<const std::uint8_t> data) {
+        const auto* p         = data.data();
+        const auto* const end = p + data.size();
+        while (p < end) {
+            const std::uint8_t lead = *p;
+            if (lead < 0x80) {
+                ++p;
+                continue;
+            }
+
+            int extra;
+            char32_t cp;
+            if (lead >= 0xC2 && lead <= 0xDF) {
+                extra = 1, cp = lead & 0x1F;
+            } else if ((lead & 0xF0) == 0xE0) {
+                extra = 2, cp = lead & 0x0F;
+            } else if (lead >= 0xF0 && lead <= 0xF4) {
+                extra = 3, cp = lead & 0x07;
+            } else {
+                return false;
+            }
+            if (end - p <= extra) {
+                return false;
+            }
+            for (int i = 1; i <= extra; ++i) {
+                if ((p[i] & 0xC0) != 0x80) {
+                    return false;
+                }
+                cp = (cp << 6) | (p[i] & 0x3F);
+            }
+            const bool overlong = (extra == 2 && cp < 0x800) || (extra == 3 && cp < 0x10000);
+            if (overlong || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+                return false;
+            }
+            p += extra + 1;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 将原始字节逐个追加为宽字符（每个 wchar_t 存放一个字节），配合 CharacterSet::BINARY 使用
+     */
+    inline void append_bytes_as_wide(std::wstring& out, std::span<const std::uint8_t> data) {
+        out.reserve(out.size() + data.size());
+        for (const std::uint8_t byte : data) {
+            out.push_back(static_cast<wchar_t>(byte));
+        }
+    }
+
+    namespace detail {
+        template <typename String>
+        [[nodiscard]] module_matrix encode_to_modules(const String& text, const QRcode_create_config& qrcode_config,
+                                                      ZXing::CharacterSet encoding = ZXing::CharacterSet::Unknown) {
+            ZXing::MultiFormatWriter writer(qrcode_config.format);
+            // 只取 1:1 的模块矩阵，放大和留白交给 rasterize_modules
+            writer.setMargin(0);
+            if (encoding != ZXing::CharacterSet::Unknown) {
+                writer.setEncoding(encoding);
+            }
+
+            return {writer.encode(text, 0, 0), qrcode_config};
+        }
+    }
+
+    /**
+     * @brief 只编码出模块矩阵，不光栅化；参数与 byte_to_QRCode_qimage 相同
+     */
+    [[nodiscard]] inline module_matrix byte_to_QRCode_modules(const std::string& text, const QRcode_create_config qrcode_config){
+        return detail::encode_to_modules(text, qrcode_config);
+    }
+
+    [[nodiscard]] inline module_matrix byte_to_QRCode_modules(const std::wstring& text, const QRcode_create_config qrcode_config){
+        return detail::encode_to_modules(text, qrcode_config);
+    }
+
+    [[nodiscard]] inline module_matrix binary_to_QRCode_modules(const std::wstring& bytes, const QRcode_create_config qrcode_config){
+        return detail::encode_to_modules(bytes, qrcode_config, ZXing::CharacterSet::BINARY);
+    }
+
+    [[nodiscard]] inline QImage byte_to_QRCode_qimage(const std::string& text, const QRcode_create_config qrcode_config){
+        return byte_to_QRCode_modules(text, qrcode_config).render();
+    }
+
+    /**
+     * @brief 宽字符串版本，ZXing 直接使用入参，不再做 UTF-8 到宽字符的转换拷贝
+     */
+    [[nodiscard]] inline QImage byte_to_QRCode_qimage(const std::wstring& text, const QRcode_create_config qrcode_config){
+        return byte_to_QRCode_modules(text, qrcode_config).render();
+    }
+
+    /**
+     * @brief 原始字节模式：以 CharacterSet::BINARY 写入字节模式，条码中带有二进制 ECI
+     * @param bytes 每个 wchar_t 存放一个字节，见 append_bytes_as_wide
+     */
+    [[nodiscard]] inline QImage binary_to_QRCode_qimage(const std::wstring& bytes, const QRcode_create_config qrcode_config){
+        return binary_to_QRCode_modules(bytes, qrcode_config).render();
+    }
+
     struct result_i2t { //image to text result, 傻瓜式expected
         enum errcode{
             success,
@@ -109,6 +573,7 @@ namespace convert{
         };
         std::string text{};
         errcode err{};
+        bool binary = false; /**< text 中是条码的原始字节（ZXing 判定为 ContentType::Binary），不是文本 */
 
         [[nodiscard]] explicit(false) result_i2t(const std::string& text) : text(text) {}
 
@@ -122,23 +587,235 @@ namespace convert{
         }
     };
 
-    [[nodiscard]] inline result_i2t QRcode_to_byte(const std::string& file_path){
-        const cv::Mat img = cv::imread(file_path, cv::IMREAD_COLOR);
-        if (img.empty()) {
-            return result_i2t::empty_img;
+    /**
+     * @brief 取出条码内容：二进制内容取原始字节，其余取 UTF-8 文本
+     *
+     * 原始字节模式生成的条码带有二进制 ECI，ZXing 判定为 ContentType::Binary，
+     * 此时 text() 会按猜测的字符集转码，必须改用 bytes() 才能还原原始数据。
+     */
+    [[nodiscard]] inline result_i2t barcode_content(const ZXing::Barcode& barcode) {
+        if (barcode.contentType() == ZXing::ContentType::Binary) {
+            const auto& bytes = barcode.bytes();
+            result_i2t result{std::string(bytes.begin(), bytes.end())};
+            result.binary = true;
+            return result;
         }
+        return {barcode.text()};
+    }
 
-        cv::Mat grayImg;
-        cv::cvtColor(img, grayImg, cv::COLOR_BGR2GRAY);
+    /**
+     * @brief 识别强度，决定 ZXing 额外尝试的变换
+     */
+    enum class decode_effort {
+        fast,     /**< 不旋转、不反色、不加强，适合软件生成的清晰图片 */
+        balanced, /**< 加强检测并尝试旋转，不尝试反色；都失败后再以 thorough 在原始分辨率上试一次 */
+        thorough, /**< ZXing 默认的全部尝试，与旧版本行为一致 */
+    };
 
-        const ZXing::ImageView imageView(grayImg.data, grayImg.cols, grayImg.rows, ZXing::ImageFormat::Lum);
-        const auto result = ZXing::ReadBarcode(imageView);
+    /**
+     * @brief 解码配置：限定格式集合和识别强度
+     */
+    struct decode_profile {
+        ZXing::BarcodeFormats formats{};               /**< 只识别这些格式，为空表示全部格式 */
+        decode_effort effort = decode_effort::thorough;
+        bool fallback_all_formats = true;              /**< 限定格式识别失败时，再用全部格式在原始分辨率上尝试一次 */
+
+        [[nodiscard]] ZXing::ReaderOptions reader_options() const {
+            ZXing::ReaderOptions options;
+            options.setFormats(formats);
+            switch (effort) {
+            case decode_effort::fast:
+                options.setTryHarder(false).setTryRotate(false).setTryInvert(false).setTryDownscale(true);
+                break;
+            case decode_effort::balanced:
+                options.setTryHarder(true).setTryRotate(true).setTryInvert(false).setTryDownscale(true);
+                break;
+            case decode_effort::thorough:
+                break;
+            }
+            return options;
+        }
+
+        /**
+         * @brief 前面的尝试都失败后，在原始分辨率上最后一次识别的选项；不需要再试时返回 std::nullopt
+         *
+         * 均衡强度在这里补上反色等全面尝试，反色条码不会因为默认强度而识别失败；
+         * 限定格式且允许回退时同时放开全部格式，两者合并为一次尝试。
+         */
+        [[nodiscard]] std::optional<ZXing::ReaderOptions> fallback_options() const {
+            const bool widen  = !formats.empty() && fallback_all_formats;
+            const bool deepen = effort == decode_effort::balanced;
+            if (!widen && !deepen) {
+                return std::nullopt;
+            }
+            auto options = deepen ? decode_profile{formats, decode_effort::thorough}.reader_options() : reader_options();
+            if (widen) {
+                options.setFormats({});
+            }
+            return options;
+        }
+
+        /**
+         * @brief 解析 "fast" / "balanced" / "thorough"，无法识别时返回 std::nullopt
+         */
+        [[nodiscard]] static std::optional<decode_effort> effort_from_string(std::string_view name) {
+            if (name == "fast")
+                return decode_effort::fast;
+            if (name == "balanced")
+                return decode_effort::balanced;
+            if (name == "thorough")
+                return decode_effort::thorough;
+            return std::nullopt;
+        }
+    };
+
+    /**
+     * @brief 解码过程的记录，供基准测试和日志使用
+     */
+    struct decode_trace {
+        int scale = 0;              /**< 识别成功时图片的缩小倍数，1 为原始分辨率，0 表示未识别 */
+        int passes = 0;             /**< 尝试识别的次数 */
+        std::size_t peak_bytes = 0; /**< 同时驻留的图像缓冲区峰值（字节） */
+    };
+
+    /**
+     * @brief 缩小分辨率尝试识别时，图片短边不低于该值
+     *
+     * 低于这个尺寸时条码模块可能缩到 1~2 像素以下，缩小识别大概率失败，反而多一次无用功。
+     */
+    inline constexpr int min_reduced_side = 800;
+
+    namespace detail {
+        [[nodiscard]] inline int reduced_imread_flag(int scale) {
+            switch (scale) {
+            case 2:  return cv::IMREAD_REDUCED_GRAYSCALE_2;
+            case 4:  return cv::IMREAD_REDUCED_GRAYSCALE_4;
+            case 8:  return cv::IMREAD_REDUCED_GRAYSCALE_8;
+            default: return cv::IMREAD_GRAYSCALE;
+            }
+        }
 
-        if (!result.isValid()) {
+        [[nodiscard]] inline std::size_t mat_bytes(const cv::Mat& mat) {
+            return mat.total() * mat.elemSize();
+        }
+
+        [[nodiscard]] inline ZXing::Barcode read_gray(const cv::Mat& gray, const ZXing::ReaderOptions& options) {
+            const timing::scoped_timer timer(timing::stage::zxing_decode);
+            const ZXing::ImageView imageView(gray.data, gray.cols, gray.rows, ZXing::ImageFormat::Lum, static_cast<int>(gray.step));
+            return ZXing::ReadBarcode(imageView, options);
+        }
+    }
+
+    namespace detail {
+        /**
+         * @brief QRcode_to_byte 的识别流程，load(flag) 按 cv::imread 的标志取得灰度图，图片来自文件还是内存由调用方决定
+         */
+        template <typename Load>
+        [[nodiscard]] result_i2t decode_image(QImageReader& probe, Load&& decodeImage, const decode_profile& profile, decode_trace* trace) {
+            const auto load = [&decodeImage](int flag) {
+                const timing::scoped_timer timer(timing::stage::imread);
+                return decodeImage(flag);
+            };
+            decode_trace local;
+            decode_trace& t = trace ? *trace : local;
+            t = {};
+
+            // 只读文件头获取尺寸和格式，不解码像素
+            const QSize size      = probe.size();
+            const bool nativeScale = probe.format() == "jpeg";
+            const int shortSide   = size.isValid() ? std::min(size.width(), size.height()) : 0;
+            const auto options    = profile.reader_options();
+
+            const auto accept = [&t](const ZXing::Barcode& barcode, int scale) -> std::optional<result_i2t> {
+                ++t.passes;
+                if (!barcode.isValid()) {
+                    return std::nullopt;
+                }
+                t.scale = scale;
+                return barcode_content(barcode);
+            };
+
+            cv::Mat full;
+            for (int scale = 4; scale >= 2; scale /= 2) {
+                if (shortSide / scale < min_reduced_side) {
+                    continue;
+                }
+
+                cv::Mat reduced;
+                if (nativeScale) {
+                    reduced = load(detail::reduced_imread_flag(scale));
+                } else {
+                    if (full.empty()) {
+                        full = load(cv::IMREAD_GRAYSCALE);
+                        if (full.empty()) {
+                            return result_i2t::empty_img;
+                        }
+                    }
+                    cv::resize(full, reduced, cv::Size{}, 1.0 / scale, 1.0 / scale, cv::INTER_AREA);
+                }
+                if (reduced.empty()) {
+                    continue;
+                }
+                t.peak_bytes = std::max(t.peak_bytes, detail::mat_bytes(full) + detail::mat_bytes(reduced));
+
+                if (auto result = accept(detail::read_gray(reduced, options), scale)) {
+                    return std::move(*result);
+                }
+            }
+
+            if (full.empty()) {
+                full = load(cv::IMREAD_GRAYSCALE);
+                if (full.empty()) {
+                    return result_i2t::empty_img;
+                }
+            }
+            t.peak_bytes = std::max(t.peak_bytes, detail::mat_bytes(full));
+
+            if (auto result = accept(detail::read_gray(full, options), 1)) {
+                return std::move(*result);
+            }
+            // 限定的格式没有识别到（可能是用户选错了格式）或均衡强度没有尝试反色，放宽选项再试一次
+            if (const auto fallback = profile.fallback_options()) {
+                if (auto result = accept(detail::read_gray(full, *fallback), 1)) {
+                    return std::move(*result);
+                }
+            }
             return result_i2t::invalid_qrcode;
         }
+    }
 
-        return result.text();
+    /**
+     * @brief 识别图片中的条码
+     *
+     * 直接按灰度读取，不再经过彩色图和 cvtColor。大图先按 4 倍、2 倍缩小后识别，
+     * 都失败才回退到原始分辨率：JPEG 由解码器直接输出缩小的图像（IMREAD_REDUCED_GRAYSCALE_*），
+     * 其它格式只解码一次原图，再用 INTER_AREA 逐级缩小。
+     *
+     * @param profile 限定格式与识别强度，默认识别全部格式
+     * @param trace 可选，记录识别成功的缩放倍数、尝试次数和图像缓冲区峰值
+     */
+    [[nodiscard]] inline result_i2t QRcode_to_byte(const std::string& file_path, const decode_profile& profile = {},
+                                                   decode_trace* trace = nullptr){
+        QImageReader probe(QString::fromLocal8Bit(file_path.data(), static_cast<int>(file_path.size())));
+        return detail::decode_image(probe, [&](int flag) { return cv::imread(file_path, flag); }, profile, trace);
+    }
+
+    /**
+     * @brief 识别已读入内存的图片文件内容中的条码，流程与按路径识别相同
+     *
+     * 批处理的读取阶段在 I/O 线程中把整个文件读入 encoded，这里只做解码和识别，不再访问磁盘。
+     */
+    [[nodiscard]] inline result_i2t QRcode_to_byte(const QByteArray& encoded, const decode_profile& profile = {},
+                                                   decode_trace* trace = nullptr) {
+        if (encoded.isEmpty()) {
+            return result_i2t::empty_img;
+        }
+        QBuffer buffer;
+        buffer.setData(encoded);
+        buffer.open(QIODevice::ReadOnly);
+        QImageReader probe(&buffer);
+        const cv::Mat data(1, static_cast<int>(encoded.size()), CV_8U, const_cast<char*>(encoded.constData()));
+        return detail::decode_image(probe, [&](int flag) { return cv::imdecode(data, flag); }, profile, trace);
     }
 
 }
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QString>
+#include <QStringList>
+#include <QtConcurrent>
+#include <spdlog/spdlog.h>
+
+#include "pipeline.h"
+
+/**
+ * @file file_walker.h
+ * @brief 批处理输入的展开：文件、目录（递归）和通配符
+ *
+ * 用 QDirIterator 逐个枚举，从不收集完整的文件列表；配合 input_queue 在后台线程中边枚举边交给流水线，
+ * 第一个文件找到后就开始处理，几万个文件的目录树也不会在内存中展开。
+ */
+namespace workers {
+
+    /**
+     * @brief 一个目录或通配符输入展开后的枚举参数
+     *
+     * 支持两种通配符形式：<目录>/<模式> 只枚举该目录，<目录>/**\/<模式> 递归枚举全部子目录。
+     * 目录部分不能含通配符；其它写法中出现 ** 时按递归处理，模式取最后一段。
+     */
+    struct walk_spec {
+        QString root;
+        QStringList nameFilters; /**< 文件名模式，为空时不过滤 */
+        bool recursive = false;
+
+        /**
+         * @brief 输入是否含通配符
+         */
+        [[nodiscard]] static bool has_wildcard(const QString& input) {
+            return input.contains('*') || input.contains('?') || input.contains('[');
+        }
+
+        /**
+         * @brief 输入是否需要枚举（目录或通配符），普通文件返回 false
+         */
+        [[nodiscard]] static bool is_walk_input(const QString& input) {
+            return has_wildcard(input) || QFileInfo(input).isDir();
+        }
+
+        /**
+         * @return 输入是普通文件或不存在的目录时返回 std::nullopt
+         */
+        [[nodiscard]] static std::optional<walk_spec> parse(const QString& input) {
+            if (!has_wildcard(input)) {
+                if (!QFileInfo(input).isDir()) {
+                    return std::nullopt;
+                }
+                // 直接给出的目录总是递归枚举
+                return walk_spec{input, {}, true};
+            }
+
+            const QStringList segments = QDir::fromNativeSeparators(input).split('/');
+            int first                  = 0;
+            while (first < segments.size() && !has_wildcard(segments[first])) {
+                ++first;
+            }
+            walk_spec spec;
+            spec.root      = first == 0 ? QString(".") : segments.mid(0, first).join('/');
+            spec.recursive = segments.mid(first).contains("**") || first < segments.size() - 1;
+            if (segments.back() != "**") {
+                spec.nameFilters = QStringList{segments.back()};
+            }
+            if (spec.root.isEmpty()) {
+                spec.root = "/"; // 以 / 开头的绝对路径
+            }
+            if (!QFileInfo(spec.root).isDir()) {
+                return std::nullopt;
+            }
+            return spec;
+        }
+    };
+
+    /**
+     * @brief 依次展开 inputs，每找到一个文件就在当前线程调用一次 emit(path, relativeDir)
+     *
+     * 普通文件原样交给 emit，目录和通配符逐个枚举；不跟随符号链接，避免目录环。
+     * 不存在的输入记录警告后跳过。
+     *
+     * @param emit relativeDir 为文件所在目录相对于枚举根目录的路径，在根目录下或输入是普通文件时为空；
+     *             返回 false 时立即停止枚举
+     * @return 被 emit 中止时返回 false
+     */
+    template <typename Emit>
+    bool walk_inputs(const QStringList& inputs, Emit&& emit) {
+        for (const QString& input : inputs) {
+            if (input.isEmpty()) {
+                continue;
+            }
+            const auto spec = walk_spec::parse(input);
+            if (!spec) {
+                if (QFileInfo(input).isFile()) {
+                    if (!emit(input, QString{})) {
+                        return false;
+                    }
+                } else {
+                    spdlog::warn("忽略不存在的输入: {}", input.toStdString());
+                }
+                continue;
+            }
+
+            const QDir root(spec->root);
+            QDirIterator it(spec->root, spec->nameFilters, QDir::Files | QDir::NoDotAndDotDot,
+                spec->recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+            while (it.hasNext()) {
+                const QString path = it.next();
+                QString relativeDir = root.relativeFilePath(it.fileInfo().path());
+                if (relativeDir == ".") {
+                    relativeDir.clear();
+                }
+                if (!emit(path, relativeDir)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief 在生产者线程中展开 inputs，每个文件经 expand 转换为零到多个输入项后送入返回的队列
+     *
+     * 队列满时枚举暂停，流水线取消后枚举随即停止。
+     *
+     * @param expand expand(path, relativeDir) 返回 QList<输入项>，不需要的文件返回空列表（如生成时跳过图片）；
+     *               relativeDir 见 walk_inputs，在生产者线程中调用
+     */
+    template <typename Expand>
+    [[nodiscard]] auto walk_into_queue(batch_pools& pools, QStringList inputs, Expand expand) {
+        using item_type = typename std::invoke_result_t<const Expand&, const QString&, const QString&>::value_type;
+
+        // 队列只需要让流水线不断粮，多缓冲几个窗口即可
+        auto queue = std::make_shared<input_queue<item_type>>(static_cast<std::size_t>(pools.window()) * 4);
+        QtConcurrent::run(pools.producer(), [queue, inputs = std::move(inputs), expand = std::move(expand)] {
+            walk_inputs(inputs, [&](const QString& path, const QString& relativeDir) {
+                if (queue->stopped()) {
+                    return false;
+                }
+                for (auto& item : expand(path, relativeDir)) {
+                    if (!queue->push(std::move(item))) {
+                        return false;
+                    }
+                }
+                return true;
+            });
+            queue->close();
+        });
+        return queue;
+    }
+
+} // namespace workers
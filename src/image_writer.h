@@ -0,0 +1,297 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QFile>
+#include <QImage>
+#include <QString>
+#include <QStringList>
+#include <nlohmann/json.hpp>
+
+/**
+ * @file image_writer.h
+ * @brief 生成结果的紧凑输出：1 位 PNG、PBM 和模块矩阵
+ *
+ * 生成的条码只有黑白两色，8 位灰度 PNG 每像素多占 7 位，libpng 还要逐行尝试全部过滤器。
+ * 这里直接把扫描线打包成 1 位，整段交给 qCompress 压缩后拼成 PNG 的各个块，一次写入文件；
+ * 同一模块行放大出来的扫描线完全相同，使用 Up 过滤器后全是 0，压缩几乎不花时间。
+ */
+namespace convert {
+
+    /**
+     * @brief 生成结果的保存格式
+     */
+    enum class image_format {
+        png,      /**< QImage::save 输出的 8 位灰度 PNG，与旧版本一致 */
+        png_1bit, /**< 1 位灰度 PNG，像素与 png 完全相同 */
+        pbm,      /**< 二进制 PBM（P4），不压缩，写入最快 */
+        modules,  /**< 模块矩阵：每个模块一个像素、不含留白的 PBM，可用于其它工具重新放大 */
+    };
+
+    /**
+     * @brief 保存参数
+     */
+    struct image_save_options {
+        image_format format = image_format::png_1bit;
+        int png_level       = 6; /**< 1 位 PNG 的 zlib 压缩等级，0~9，-1 为 zlib 默认 */
+
+        /**
+         * @brief 对应格式的文件扩展名（不含点）
+         */
+        [[nodiscard]] QString suffix() const { return format == image_format::png || format == image_format::png_1bit ? "png" : "pbm"; }
+
+        /**
+         * @brief 解析 "png" / "png1" / "pbm" / "modules"，无法识别时返回 std::nullopt
+         */
+        [[nodiscard]] static std::optional<image_format> format_from_string(std::string_view name) {
+            if (name == "png")
+                return image_format::png;
+            if (name == "png1")
+                return image_format::png_1bit;
+            if (name == "pbm")
+                return image_format::pbm;
+            if (name == "modules")
+                return image_format::modules;
+            return std::nullopt;
+        }
+
+        /**
+         * @brief 从配置文件的 "output" 节读取保存参数（"format"、"png_level"），缺省项保持默认值
+         */
+        static image_save_options loadOutputConfig(const std::string& filename) {
+            image_save_options options;
+
+            std::ifstream file(filename);
+            if (!file.is_open()) {
+                return options;
+            }
+
+            const auto json = nlohmann::json::parse(file, nullptr, false);
+            if (json.is_discarded() || !json.contains("output")) {
+                return options;
+            }
+
+            const auto& output_cfg = json["output"];
+            if (output_cfg.contains("format")) {
+                if (const auto format = format_from_string(output_cfg["format"].get<std::string>()))
+                    options.format = *format;
+            }
+            if (output_cfg.contains("png_level"))
+                options.png_level = std::clamp(output_cfg["png_level"].get<int>(), -1, 9);
+            return options;
+        }
+    };
+
+    /**
+     * @brief 光栅化时记录在 QImage 文本中的模块网格，键为 module_geometry::key
+     */
+    struct module_geometry {
+        int left = 0, top = 0;        /**< 第一个模块左上角的像素坐标 */
+        int columns = 0, rows = 0;    /**< 模块数 */
+        int scale_x = 0, scale_y = 0; /**< 每个模块的像素尺寸 */
+
+        static constexpr const char* key = "L2Q-Modules";
+
+        void store(QImage& image) const {
+            image.setText(key, QString("%1,%2,%3,%4,%5,%6").arg(left).arg(top).arg(columns).arg(rows).arg(scale_x).arg(scale_y));
+        }
+
+        /**
+         * @return 图片没有记录网格或记录与尺寸不符时返回 std::nullopt
+         */
+        [[nodiscard]] static std::optional<module_geometry> load(const QImage& image) {
+            const QStringList fields = image.text(key).split(',');
+            if (fields.size() != 6) {
+                return std::nullopt;
+            }
+            module_geometry g{fields[0].toInt(), fields[1].toInt(), fields[2].toInt(), fields[3].toInt(), fields[4].toInt(), fields[5].toInt()};
+            if (g.columns <= 0 || g.rows <= 0 || g.scale_x <= 0 || g.scale_y <= 0 || g.left < 0 || g.top < 0
+                || g.left + g.columns * g.scale_x > image.width() || g.top + g.rows * g.scale_y > image.height()) {
+                return std::nullopt;
+            }
+            return g;
+        }
+    };
+
+    namespace detail {
+        inline constexpr auto crc_table = [] {
+            std::array<std::uint32_t, 256> table{};
+            for (std::uint32_t n = 0; n < 256; ++n) {
+                std::uint32_t c = n;
+                for (int k = 0; k < 8; ++k) {
+                    c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                table[n] = c;
+            }
+            return table;
+        }();
+
+        [[nodiscard]] inline std::uint32_t crc32(const char* data, std::size_t len, std::uint32_t crc = 0) {
+            crc = ~crc;
+            for (std::size_t i = 0; i < len; ++i) {
+                crc = crc_table[(crc ^ static_cast<std::uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+            }
+            return ~crc;
+        }
+
+        inline void append_be32(QByteArray& out, std::uint32_t v) {
+            const char bytes[] = {static_cast<char>(v >> 24), static_cast<char>(v >> 16), static_cast<char>(v >> 8), static_cast<char>(v)};
+            out.append(bytes, 4);
+        }
+
+        inline void append_chunk(QByteArray& out, const char type[4], const char* data, int len) {
+            append_be32(out, static_cast<std::uint32_t>(len));
+            const int start = out.size();
+            out.append(type, 4);
+            out.append(data, len);
+            append_be32(out, crc32(out.constData() + start, static_cast<std::size_t>(len) + 4));
+        }
+
+        /**
+         * @brief 把一行灰度像素打包为 1 位，最高位在前；black_bit 为黑色像素（< 128）对应的位值，行尾补白色
+         */
+        inline void pack_row(const uchar* src, int width, std::uint8_t* dst, bool black_bit) {
+            const std::uint8_t flip = black_bit ? 0xFF : 0x00;
+            int x = 0;
+            for (; x + 8 <= width; x += 8, src += 8) {
+                std::uint8_t bits = 0;
+                for (int k = 0; k < 8; ++k) {
+                    bits = static_cast<std::uint8_t>(bits << 1 | (src[k] >> 7));
+                }
+                *dst++ = bits ^ flip;
+            }
+            if (x < width) {
+                std::uint8_t bits = 0;
+                for (int k = 0; k < 8; ++k) {
+                    bits = static_cast<std::uint8_t>(bits << 1 | (x + k < width ? src[k] >> 7 : 1));
+                }
+                *dst = bits ^ flip;
+            }
+        }
+
+        [[nodiscard]] inline QImage to_gray(const QImage& image) {
+            return image.format() == QImage::Format_Grayscale8 ? image : image.convertToFormat(QImage::Format_Grayscale8);
+        }
+
+        /**
+         * @brief 按模块网格取每个模块中心的像素，得到每模块一个像素的灰度图
+         */
+        [[nodiscard]] inline QImage sample_modules(const QImage& gray, const module_geometry& g) {
+            QImage modules(g.columns, g.rows, QImage::Format_Grayscale8);
+            for (int my = 0; my < g.rows; ++my) {
+                const uchar* src = gray.constScanLine(g.top + my * g.scale_y + g.scale_y / 2) + g.left + g.scale_x / 2;
+                uchar* dst       = modules.scanLine(my);
+                for (int mx = 0; mx < g.columns; ++mx) {
+                    dst[mx] = src[static_cast<std::ptrdiff_t>(mx) * g.scale_x];
+                }
+            }
+            return modules;
+        }
+    }
+
+    /**
+     * @brief 编码为 1 位灰度 PNG
+     *
+     * 与上一行相同的扫描线用 Up 过滤器（整行为 0），其余不过滤；IDAT 取 qCompress 去掉 4 字节长度前缀后的 zlib 流。
+     */
+    [[nodiscard]] inline QByteArray encode_png_1bit(const QImage& image, int level = 6) {
+        const QImage gray = detail::to_gray(image);
+        const int width   = gray.width();
+        const int height  = gray.height();
+        const int stride  = (width + 7) / 8 + 1;
+
+        QByteArray raw(stride * height, Qt::Uninitialized);
+        auto* row = reinterpret_cast<std::uint8_t*>(raw.data());
+        for (int y = 0; y < height; ++y, row += stride) {
+            if (y > 0 && std::memcmp(gray.constScanLine(y), gray.constScanLine(y - 1), static_cast<std::size_t>(width)) == 0) {
+                row[0] = 2; // Up
+                std::memset(row + 1, 0, static_cast<std::size_t>(stride - 1));
+            } else {
+                row[0] = 0; // None
+                detail::pack_row(gray.constScanLine(y), width, row + 1, false);
+            }
+        }
+        const QByteArray compressed = qCompress(raw, level);
+
+        QByteArray png;
+        png.reserve(8 + 25 + 12 + compressed.size() + 12);
+        png.append("\x89PNG\r\n\x1A\n", 8);
+
+        QByteArray ihdr;
+        detail::append_be32(ihdr, static_cast<std::uint32_t>(width));
+        detail::append_be32(ihdr, static_cast<std::uint32_t>(height));
+        ihdr.append("\x01\x00\x00\x00\x00", 5); // 位深 1、灰度、deflate、标准过滤、不隔行
+        detail::append_chunk(png, "IHDR", ihdr.constData(), ihdr.size());
+        detail::append_chunk(png, "IDAT", compressed.constData() + 4, compressed.size() - 4);
+        detail::append_chunk(png, "IEND", nullptr, 0);
+        return png;
+    }
+
+    /**
+     * @brief 编码为二进制 PBM（P4，1 为黑）
+     */
+    [[nodiscard]] inline QByteArray encode_pbm(const QImage& image) {
+        const QImage gray = detail::to_gray(image);
+        const int stride  = (gray.width() + 7) / 8;
+
+        QByteArray pbm = QString("P4\n%1 %2\n").arg(gray.width()).arg(gray.height()).toLatin1();
+        const int header = pbm.size();
+        pbm.resize(header + stride * gray.height());
+        auto* row = reinterpret_cast<std::uint8_t*>(pbm.data() + header);
+        for (int y = 0; y < gray.height(); ++y, row += stride) {
+            detail::pack_row(gray.constScanLine(y), gray.width(), row, true);
+        }
+        return pbm;
+    }
+
+    /**
+     * @brief 按保存参数编码
+     * @return 图片没有模块网格信息时（modules 格式）返回空
+     */
+    [[nodiscard]] inline QByteArray encode_image(const QImage& image, const image_save_options& options) {
+        switch (options.format) {
+        case image_format::png_1bit:
+            return encode_png_1bit(image, options.png_level);
+        case image_format::pbm:
+            return encode_pbm(image);
+        case image_format::modules:
+            if (const auto geometry = module_geometry::load(image)) {
+                return encode_pbm(detail::sample_modules(detail::to_gray(image), *geometry));
+            }
+            return {};
+        case image_format::png: {
+            QByteArray png;
+            QBuffer buffer(&png);
+            buffer.open(QIODevice::WriteOnly);
+            image.save(&buffer, "PNG");
+            return png;
+        }
+        }
+        return {};
+    }
+
+    /**
+     * @brief 按保存参数写出图片，整个文件一次写入
+     */
+    [[nodiscard]] inline bool write_image(const QImage& image, const QString& path, const image_save_options& options) {
+        if (options.format == image_format::png) {
+            return image.save(path);
+        }
+        const QByteArray data = encode_image(image, options);
+        if (data.isEmpty()) {
+            return false;
+        }
+        QFile file(path);
+        return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+    }
+
+} // namespace convert
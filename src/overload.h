@@ -0,0 +1,31 @@
+#pragma once
+
+#include <concepts>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief std::visit 用的重载集合，未匹配的备选类型返回默认构造的 Ret（或什么也不做）
+ */
+template <typename Ret, typename... Fs>
+    requires(std::is_void_v<Ret> || std::is_default_constructible_v<Ret>)
+struct overload_def_noop : private Fs... {
+    template <typename V, typename... Args>
+    constexpr explicit(false) overload_def_noop(std::in_place_type_t<V>, Args&&... fs) :
+        Fs{std::forward<Args>(fs)}... {}
+
+    using Fs::operator()...;
+
+    template <typename... T>
+        requires(!std::invocable<Fs, T...> && ...)
+    Ret operator()(T&&...) const noexcept {
+        if constexpr (std::is_void_v<Ret>) {
+            return;
+        } else {
+            return Ret{};
+        }
+    }
+};
+
+template <typename V, typename... Fs>
+overload_def_noop(std::in_place_type_t<V>, Fs&&...) -> overload_def_noop<V, std::decay_t<Fs>...>;
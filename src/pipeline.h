@@ -0,0 +1,552 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <QFuture>
+#include <QFutureInterface>
+#include <QList>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+/**
+ * @file pipeline.h
+ * @brief 批处理的分阶段流水线：读取 → 转换 → 写入
+ *
+ * 读文件、写文件这类阻塞 I/O 放在线程数有限的 I/O 池中，编码、识别等计算放在与核心数相同的 CPU 池中，
+ * 计算线程不会因为等待磁盘而闲置，磁盘也不会被过多的并发请求打散。
+ * 同时在途（已开始读取、尚未完成）的任务数受窗口限制，读取快于计算时不会把整批文件都读进内存。
+ * 输入可以是现成的列表，也可以由生产者线程边枚举边送入 input_queue，流水线随到随处理。
+ */
+namespace workers {
+
+    /**
+     * @brief 流水线配置
+     */
+    struct pipeline_config {
+        int io_threads  = 4; /**< I/O 池线程数 */
+        int cpu_threads = 0; /**< CPU 池线程数，0 表示与核心数相同 */
+        int window      = 0; /**< 同时在途的任务数上限，0 表示 CPU 线程数的 2 倍 */
+        int dedup_entries = 4096; /**< 批次内去重保留的最近结果数，0 表示不去重 */
+
+        /**
+         * @brief 从配置文件的 "pipeline" 节读取流水线配置（"io_threads"、"cpu_threads"、"window"、"dedup_entries"），缺省项保持默认值
+         */
+        static pipeline_config loadPipelineConfig(const std::string& filename) {
+            pipeline_config config;
+
+            std::ifstream file(filename);
+            if (!file.is_open()) {
+                return config;
+            }
+
+            const auto json = nlohmann::json::parse(file, nullptr, false);
+            if (json.is_discarded() || !json.contains("pipeline")) {
+                return config;
+            }
+
+            const auto& pipeline_cfg = json["pipeline"];
+            if (pipeline_cfg.contains("io_threads"))
+                config.io_threads = std::max(1, pipeline_cfg["io_threads"].get<int>());
+            if (pipeline_cfg.contains("cpu_threads"))
+                config.cpu_threads = std::max(0, pipeline_cfg["cpu_threads"].get<int>());
+            if (pipeline_cfg.contains("window"))
+                config.window = std::max(0, pipeline_cfg["window"].get<int>());
+            if (pipeline_cfg.contains("dedup_entries"))
+                config.dedup_entries = std::max(0, pipeline_cfg["dedup_entries"].get<int>());
+            return config;
+        }
+    };
+
+    /**
+     * @brief 流水线使用的两个线程池
+     *
+     * 与全局线程池分开，QtConcurrent 的其它任务（如整页识别的分块）不会占满 I/O 池。
+     * 另有一个小的生产者池，用于边枚举边送入 input_queue。
+     * 析构时等待两个池中的任务全部结束。
+     */
+    class batch_pools {
+    public:
+        explicit batch_pools(const pipeline_config& config = {}) {
+            producer_.setMaxThreadCount(2);
+            io_.setMaxThreadCount(config.io_threads);
+            cpu_.setMaxThreadCount(config.cpu_threads > 0 ? config.cpu_threads : QThread::idealThreadCount());
+            window_ = config.window > 0 ? config.window : cpu_.maxThreadCount() * 2;
+        }
+
+        batch_pools(const batch_pools&)            = delete;
+        batch_pools& operator=(const batch_pools&) = delete;
+
+        ~batch_pools() {
+            // 任务会在两个池之间转交，一边等完时另一边可能又收到新任务，直到两边同时空闲为止
+            do {
+                producer_.waitForDone();
+                io_.waitForDone();
+                cpu_.waitForDone();
+            } while (!producer_.waitForDone(0) || !io_.waitForDone(0) || !cpu_.waitForDone(0));
+        }
+
+        [[nodiscard]] QThreadPool* producer() { return &producer_; }
+        [[nodiscard]] QThreadPool* io() { return &io_; }
+        [[nodiscard]] QThreadPool* cpu() { return &cpu_; }
+        [[nodiscard]] int window() const { return window_; }
+
+    private:
+        QThreadPool producer_; /**< 枚举输入的生产者，大部分时间阻塞在已满的 input_queue 上，不占用 I/O 池 */
+        QThreadPool io_;
+        QThreadPool cpu_;
+        int window_ = 0;
+    };
+
+    /**
+     * @brief 流水线的输入队列：生产者逐个送入，全部送入后 close
+     *
+     * 容量有限，队列满时 push 阻塞生产者，枚举不会远远跑在处理前面，内存占用与输入总数无关。
+     * 流水线取消后 push 返回 false、stopped 返回 true，生产者应尽快停止并 close。
+     * 批处理的取消也经由队列（cancel）：流水线不再取新输入，在途的项照常走完并报告结果，QFuture 正常结束。
+     */
+    template <typename T>
+    class input_queue {
+    public:
+        explicit input_queue(std::size_t capacity) : capacity_(std::max<std::size_t>(capacity, 1)) {}
+
+        /**
+         * @brief 已经齐全的输入列表，不需要生产者
+         */
+        [[nodiscard]] static std::shared_ptr<input_queue> from_list(QList<T> items) {
+            auto queue = std::make_shared<input_queue>(static_cast<std::size_t>(items.size()));
+            queue->items_.assign(std::make_move_iterator(items.begin()), std::make_move_iterator(items.end()));
+            queue->pushed_ = items.size();
+            queue->closed_ = true;
+            return queue;
+        }
+
+        /**
+         * @brief 生产者调用，队列满时阻塞
+         * @return 流水线已取消时返回 false，item 被丢弃
+         */
+        bool push(T item) {
+            std::function<void()> notify;
+            {
+                std::unique_lock lock(mutex_);
+                space_.wait(lock, [this] { return canceled_ || items_.size() < capacity_; });
+                if (canceled_) {
+                    return false;
+                }
+                items_.push_back(std::move(item));
+                ++pushed_;
+                notify = listener_;
+            }
+            if (notify) {
+                notify();
+            }
+            return true;
+        }
+
+        /**
+         * @brief 生产者调用：全部输入已送入（或已停止）
+         */
+        void close() {
+            std::function<void()> notify;
+            {
+                std::lock_guard lock(mutex_);
+                closed_ = true;
+                notify  = listener_;
+            }
+            if (notify) {
+                notify();
+            }
+        }
+
+        /**
+         * @brief 取消批处理：丢弃尚未取出的输入并唤醒阻塞的生产者，流水线等在途的项完成后结束
+         *
+         * 与 QFuture::cancel 不同，已经开始的项仍会报告结果（QFuture 取消后报告的结果会被丢弃），
+         * 取消前写出的文件、算出的结果都能在界面中看到。可在任意线程调用。
+         */
+        void cancel() {
+            std::function<void()> notify;
+            {
+                std::lock_guard lock(mutex_);
+                discardLocked();
+                notify = listener_;
+            }
+            // 此时可能没有在途的项，由这里通知流水线结束
+            if (notify) {
+                notify();
+            }
+        }
+
+        /**
+         * @brief 流水线是否已取消，生产者在两次 push 之间（如枚举大目录时）据此提前停止
+         */
+        [[nodiscard]] bool stopped() const {
+            std::lock_guard lock(mutex_);
+            return canceled_ || (is_canceled_ && is_canceled_());
+        }
+
+        // 以下由流水线调用
+
+        /**
+         * @param listener 有新输入或关闭时在生产者线程中调用
+         * @param is_canceled 查询流水线是否已取消
+         */
+        void attach(std::function<void()> listener, std::function<bool()> is_canceled) {
+            std::lock_guard lock(mutex_);
+            listener_    = std::move(listener);
+            is_canceled_ = std::move(is_canceled);
+        }
+
+        [[nodiscard]] std::optional<T> try_pop() {
+            std::lock_guard lock(mutex_);
+            if (items_.empty()) {
+                return std::nullopt;
+            }
+            std::optional<T> item(std::move(items_.front()));
+            items_.pop_front();
+            space_.notify_one();
+            return item;
+        }
+
+        /**
+         * @brief 丢弃尚未取出的输入并唤醒阻塞的生产者，不通知流水线（流水线自己调用）
+         */
+        void discard() {
+            std::lock_guard lock(mutex_);
+            discardLocked();
+        }
+
+        /**
+         * @brief 是否已调用 cancel 或 discard
+         */
+        [[nodiscard]] bool canceled() const {
+            std::lock_guard lock(mutex_);
+            return canceled_;
+        }
+
+        [[nodiscard]] bool closed() const {
+            std::lock_guard lock(mutex_);
+            return closed_;
+        }
+
+        /**
+         * @brief 已关闭且全部取出
+         */
+        [[nodiscard]] bool drained() const {
+            std::lock_guard lock(mutex_);
+            return closed_ && items_.empty();
+        }
+
+        /**
+         * @brief 累计送入的输入数
+         */
+        [[nodiscard]] int pushed() const {
+            std::lock_guard lock(mutex_);
+            return pushed_;
+        }
+
+    private:
+        void discardLocked() {
+            canceled_ = true;
+            items_.clear();
+            space_.notify_all();
+        }
+
+        mutable std::mutex mutex_;
+        std::condition_variable space_;
+        std::deque<T> items_;
+        std::size_t capacity_;
+        int pushed_    = 0;
+        bool closed_   = false;
+        bool canceled_ = false;
+        std::function<void()> listener_;
+        std::function<bool()> is_canceled_;
+    };
+
+    /**
+     * @brief 表示流水线不需要某个阶段
+     */
+    struct no_stage {};
+
+    /**
+     * @brief 某一项的阶段抛出的异常
+     */
+    struct stage_error {
+        QString input;    /**< 出错的输入，见 pipeline_input_name */
+        std::string what; /**< 异常说明 */
+    };
+
+    /**
+     * @brief 输入项的名称，用于错误结果和日志；输入类型在其所在的命名空间中提供重载（按 ADL 查找）
+     */
+    template <typename T>
+    [[nodiscard]] QString pipeline_input_name(const T&) {
+        return {};
+    }
+
+    [[nodiscard]] inline QString pipeline_input_name(const QString& path) {
+        return path;
+    }
+
+    /**
+     * @brief 阶段抛出异常时代替该项报告的结果；结果类型在 workers 中提供重载，没有重载时为默认构造的值
+     */
+    template <typename T>
+    [[nodiscard]] T pipeline_error_result(std::type_identity<T>, const stage_error&) {
+        return T{};
+    }
+
+    namespace detail {
+
+        template <typename Stage, typename In>
+        struct stage_output {
+            using type = std::invoke_result_t<const Stage&, In>;
+        };
+
+        template <typename In>
+        struct stage_output<no_stage, In> {
+            using type = In;
+        };
+
+        template <typename Stage, typename In>
+        using stage_output_t = typename stage_output<Stage, In>::type;
+
+        /**
+         * @brief 一次流水线运行的共享状态，由各阶段的任务共同持有
+         *
+         * 从输入队列取出的项按取出顺序编号，结果按编号报告。在途数低于窗口时从队列补充，
+         * 队列已关闭且取空（或已取消）、在途为 0 时整批结束。
+         * QtConcurrent::run 会吞掉任务中的异常，所以每个阶段自己捕获异常并转为错误结果，
+         * 并由 complete_guard 保证每一项无论如何都会 complete，在途计数不会漏减、整批不会卡住。
+         */
+        template <typename In, typename Read, typename Transform, typename Write>
+        class pipeline_run : public std::enable_shared_from_this<pipeline_run<In, Read, Transform, Write>> {
+        public:
+            using read_type = stage_output_t<Read, In>;
+            using out_type  = stage_output_t<Write, std::invoke_result_t<const Transform&, read_type>>;
+
+            pipeline_run(batch_pools& pools, std::shared_ptr<input_queue<In>> inputs, Read read, Transform transform, Write write) :
+                pools_(pools), inputs_(std::move(inputs)), read_(std::move(read)), transform_(std::move(transform)),
+                write_(std::move(write)) {}
+
+            QFuture<out_type> start() {
+                future_.reportStarted();
+                QFuture<out_type> future = future_.future();
+
+                // 队列持有本对象直到整批结束，生产者还在枚举、暂时没有在途任务时也不会提前释放
+                auto self = this->shared_from_this();
+                inputs_->attach([self] { self->pump(); }, [self] { return self->future_.isCanceled(); });
+                pump();
+                return future;
+            }
+
+        private:
+            /**
+             * @brief 析构时调用 complete，除非这一项已交给下一阶段（release）
+             */
+            class complete_guard {
+            public:
+                explicit complete_guard(std::shared_ptr<pipeline_run> run) : run_(std::move(run)) {}
+                ~complete_guard() {
+                    if (run_) {
+                        run_->complete();
+                    }
+                }
+
+                complete_guard(const complete_guard&)            = delete;
+                complete_guard& operator=(const complete_guard&) = delete;
+
+                void release() { run_.reset(); }
+
+            private:
+                std::shared_ptr<pipeline_run> run_;
+            };
+
+            /**
+             * @brief 在途数低于窗口时从队列补充，已取消时丢弃队列中剩余的项，条件满足时结束整批
+             *
+             * 队列取消时只是不再补充，在途的项照常完成；QFuture 被取消（如窗口关闭）时在途的项也尽快跳过。
+             */
+            void pump() {
+                std::lock_guard lock(mutex_);
+                if (finished_) {
+                    return;
+                }
+                if (future_.isCanceled()) {
+                    inputs_->discard();
+                }
+                const bool canceled = inputs_->canceled();
+                while (!canceled && inFlight_ < pools_.window()) {
+                    auto item = inputs_->try_pop();
+                    if (!item) {
+                        break;
+                    }
+                    ++inFlight_;
+                    launch(next_++, std::move(*item));
+                }
+                updateRange();
+                if (inFlight_ == 0 && (canceled || inputs_->drained())) {
+                    finished_ = true;
+                    future_.reportFinished();
+                    inputs_->attach({}, {});
+                }
+            }
+
+            /**
+             * @brief 输入还在枚举时总数随之增长，每多出 range_step 项更新一次进度范围，关闭后更新为准确的总数
+             */
+            void updateRange() {
+                static constexpr int range_step = 256;
+                const int total                 = inputs_->pushed();
+                if (total != rangeTotal_ && (inputs_->closed() || rangeTotal_ == 0 || total - rangeTotal_ >= range_step)) {
+                    rangeTotal_ = total;
+                    future_.setProgressRange(0, total);
+                }
+            }
+
+            void launch(int index, In item) {
+                auto self = this->shared_from_this();
+                if constexpr (std::is_same_v<Read, no_stage>) {
+                    QtConcurrent::run(pools_.cpu(), [self, index, item = std::move(item)]() mutable {
+                        QString name = pipeline_input_name(item);
+                        self->runTransform(index, std::move(name), std::move(item));
+                    });
+                } else {
+                    QtConcurrent::run(pools_.io(), [self, index, item = std::move(item)] {
+                        complete_guard guard(self);
+                        if (self->future_.isCanceled()) {
+                            return;
+                        }
+                        QString name = pipeline_input_name(item);
+                        auto loaded  = self->attempt(index, name, [&] { return self->read_(item); });
+                        if (!loaded) {
+                            return;
+                        }
+                        QtConcurrent::run(self->pools_.cpu(),
+                            [self, index, name = std::move(name), loaded = std::move(*loaded)]() mutable {
+                                self->runTransform(index, std::move(name), std::move(loaded));
+                            });
+                        guard.release();
+                    });
+                }
+            }
+
+            template <typename Loaded>
+            void runTransform(int index, QString name, Loaded&& loaded) {
+                complete_guard guard(this->shared_from_this());
+                if (future_.isCanceled()) {
+                    return;
+                }
+                auto transformed = attempt(index, name, [&] { return transform_(std::forward<Loaded>(loaded)); });
+                if (!transformed) {
+                    return;
+                }
+                if constexpr (std::is_same_v<Write, no_stage>) {
+                    future_.reportResult(*transformed, index);
+                } else {
+                    auto self = this->shared_from_this();
+                    QtConcurrent::run(pools_.io(),
+                        [self, index, name = std::move(name), transformed = std::move(*transformed)]() mutable {
+                            const complete_guard writeGuard(self);
+                            // 已经算完的结果照常写出，取消只影响尚未开始的项
+                            if (auto written = self->attempt(index, name, [&] { return self->write_(std::move(transformed)); })) {
+                                self->future_.reportResult(*written, index);
+                            }
+                        });
+                    guard.release();
+                }
+            }
+
+            /**
+             * @brief 执行一个阶段，异常时报告该项的错误结果
+             * @return 阶段的返回值，抛出异常时为空
+             */
+            template <typename Stage>
+            std::optional<std::invoke_result_t<Stage&>> attempt(int index, const QString& name, Stage&& stage) {
+                try {
+                    return stage();
+                } catch (const std::exception& e) {
+                    fail(index, name, e.what());
+                } catch (...) {
+                    fail(index, name, "未知异常");
+                }
+                return std::nullopt;
+            }
+
+            void fail(int index, const QString& name, std::string what) {
+                spdlog::error("批处理第 {} 项 {} 处理失败: {}", index + 1, name.toStdString(), what);
+                future_.reportResult(pipeline_error_result(std::type_identity<out_type>{}, stage_error{name, std::move(what)}), index);
+            }
+
+            /**
+             * @brief 一项走完（或被取消跳过），更新进度并补充下一项
+             */
+            void complete() {
+                {
+                    std::lock_guard lock(mutex_);
+                    --inFlight_;
+                    future_.setProgressValue(++done_);
+                }
+                pump();
+            }
+
+            batch_pools& pools_;
+            const std::shared_ptr<input_queue<In>> inputs_;
+            const Read read_;
+            const Transform transform_;
+            const Write write_;
+            QFutureInterface<out_type> future_;
+
+            std::mutex mutex_; /**< 保护以下计数 */
+            int next_       = 0;
+            int inFlight_   = 0;
+            int done_       = 0;
+            int rangeTotal_ = 0;
+            bool finished_  = false;
+        };
+
+    } // namespace detail
+
+    /**
+     * @brief 以读取 → 转换 → 写入三个阶段处理 inputs
+     *
+     * read 和 write 在 I/O 池中执行，transform 在 CPU 池中执行；不需要的阶段传 no_stage，该阶段的输入原样交给下一阶段。
+     * 返回的 QFuture 与 QtConcurrent::mapped 的用法相同：结果按输入取出的顺序编号报告，可以通过 QFutureWatcher
+     * 逐条取得结果和跟踪进度。需要取消时调用 inputs->cancel()：尚未开始的项不再执行，已开始的项照常完成并报告结果。
+     * QFuture::cancel 也能停止流水线，但取消后报告的结果会被丢弃，只适合不再关心结果的场合（如窗口关闭）。
+     * 生产者仍在送入时进度范围随之增长，关闭后才是准确的总数。
+     * 阶段抛出的异常不会中断整批：该项以 pipeline_error_result 代替结果报告，照常计入进度。
+     *
+     * @param pools 执行任务的线程池，须比返回的 QFuture 活得久
+     */
+    template <typename In, typename Read, typename Transform, typename Write = no_stage>
+    [[nodiscard]] auto run_pipeline(batch_pools& pools, std::shared_ptr<input_queue<In>> inputs, Read read, Transform transform,
+                                    Write write = {}) {
+        auto run = std::make_shared<detail::pipeline_run<In, Read, Transform, Write>>(
+            pools, std::move(inputs), std::move(read), std::move(transform), std::move(write));
+        return run->start();
+    }
+
+    /**
+     * @brief 处理现成的输入列表，不需要中途取消时使用
+     */
+    template <typename In, typename Read, typename Transform, typename Write = no_stage>
+    [[nodiscard]] auto run_pipeline(batch_pools& pools, QList<In> inputs, Read read, Transform transform, Write write = {}) {
+        return run_pipeline(pools, input_queue<In>::from_list(std::move(inputs)), std::move(read), std::move(transform),
+            std::move(write));
+    }
+
+} // namespace workers
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <QByteArray>
+#include <QDir>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QString>
+#include <ZXing/BarcodeFormat.h>
+
+#include "convert.h"
+
+/**
+ * @file sequence.h
+ * @brief 超出单个条码容量的文件拆分为多个条码（分片），以及解码后的分片重组
+ *
+ * ZXing 的 MultiFormatWriter 不支持生成 QR Structured Append，这里改用一个文本分片头：
+ *
+ *     ~L2Q:<8 位十六进制分组 id>:<序号>/<总数>:<分片内容>
+ *
+ * 分片头位于 Base64 之外，对所有二维码格式通用；未拆分的文件不带分片头，与旧版本生成的条码完全兼容。
+ * Base45 等字母数字模式的负载改用 "$L2Q:" 前缀和大写 id，整个条码仍可走 QR 码的字母数字模式。
+ */
+namespace convert {
+
+    inline constexpr std::string_view sequence_prefix = "~L2Q:";
+
+    /**
+     * @brief 字母数字模式下使用的分片头前缀，配合大写十六进制 id，整个分片头都在 QR 码字母数字字符集内
+     */
+    inline constexpr std::string_view alphanumeric_sequence_prefix = "$L2Q:";
+    static_assert(alphanumeric_sequence_prefix.size() == sequence_prefix.size());
+
+    /**
+     * @brief 分片头的最大长度，拆分时从符号容量中预留
+     */
+    inline constexpr int sequence_header_reserve = 32;
+
+    /**
+     * @brief 字节模式下 ECI 段（4 位模式指示 + 8 位字符集编号）占用的字节数
+     *
+     * 原始字节模式写入二进制 ECI，非 Latin-1 文本写入 UTF-8 ECI，symbol_capacity 没有计入这一段。
+     */
+    inline constexpr int eci_header_reserve = 2;
+
+    /**
+     * @brief 生成分片头
+     * @param alphanumeric 负载走字母数字模式（Base45 等）时为 true，避免分片头把整个条码拉回字节模式
+     */
+    [[nodiscard]] inline std::string make_sequence_header(const sequence_info& info, bool alphanumeric = false) {
+        char id[9];
+        std::snprintf(id, sizeof(id), alphanumeric ? "%08X" : "%08x", static_cast<unsigned>(info.id));
+        return std::string(alphanumeric ? alphanumeric_sequence_prefix : sequence_prefix) + id + ":" + std::to_string(info.index)
+            + "/" + std::to_string(info.total) + ":";
+    }
+
+    /**
+     * @brief 识别并去掉文本开头的分片头
+     * @param text 解码得到的文本，识别成功时分片头会被移除
+     * @return 分片信息；文本不是分片时返回 std::nullopt 且不修改 text
+     */
+    [[nodiscard]] inline std::optional<sequence_info> take_sequence_header(std::string& text) {
+        if (!std::string_view(text).starts_with(sequence_prefix) && !std::string_view(text).starts_with(alphanumeric_sequence_prefix)) {
+            return std::nullopt;
+        }
+
+        const char* const begin = text.data() + sequence_prefix.size();
+        const char* const end   = text.data() + text.size();
+
+        // 依次解析 "<id>:" "<序号>/" "<总数>:"，每段都要以给定的分隔符结尾
+        const auto field = [end](const char* from, auto& value, char separator, int base = 10) -> const char* {
+            const auto [p, ec] = std::from_chars(from, end, value, base);
+            return ec == std::errc{} && p != end && *p == separator ? p + 1 : nullptr;
+        };
+
+        sequence_info info;
+        const char* p = field(begin, info.id, ':', 16);
+        p = p ? field(p, info.index, '/') : nullptr;
+        p = p ? field(p, info.total, ':') : nullptr;
+        if (!p || info.total < 1 || info.index < 0 || info.index >= info.total)
+            return std::nullopt;
+
+        text.erase(0, static_cast<std::size_t>(p - text.data()));
+        return info;
+    }
+
+    /**
+     * @brief 单个条码最多能容纳的字符数（字节模式、最低纠错等级，取保守值）
+     * @param alphanumeric 内容全部是字母数字模式字符时的容量，只有 QR 码比字节模式大
+     * @return 0 表示该格式不参与拆分（一维码及容量过小的格式）
+     */
+    [[nodiscard]] inline int symbol_capacity(ZXing::BarcodeFormat format, bool alphanumeric = false) {
+        if (alphanumeric && format == ZXing::BarcodeFormat::QRCode) {
+            return 4296;
+        }
+        switch (format) {
+        case ZXing::BarcodeFormat::QRCode:     return 2953;
+        case ZXing::BarcodeFormat::DataMatrix: return 1550;
+        case ZXing::BarcodeFormat::Aztec:      return 1500;
+        case ZXing::BarcodeFormat::PDF417:     return 1000;
+        case ZXing::BarcodeFormat::RMQRCode:   return 361;
+        default:                               return 0;
+        }
+    }
+
+    /**
+     * @class sequence_assembler
+     * @brief 收集解码得到的分片，凑齐一组后拼接还原为原始数据
+     *
+     * 线程安全，命令行工具在工作线程中边解码边提交；图形界面在批处理结束后一次性提交。
+     */
+    class sequence_assembler {
+    public:
+        /**
+         * @brief 提交一个分片
+         * @return 该组全部到齐时返回还原后的条目；分片总数与同组已收到的分片不一致时返回错误条目，不收下该分片；
+         *         其余情况返回 std::nullopt
+         */
+        std::optional<result_data_entry> add(result_data_entry&& part) {
+            std::lock_guard lock(mutex_);
+
+            const auto id = part.sequence.id;
+            auto& group   = groups_[id];
+            if (group.parts.empty()) {
+                group.parts.resize(static_cast<std::size_t>(part.sequence.total));
+            }
+            if (static_cast<int>(group.parts.size()) != part.sequence.total) {
+                // 同一 id 但总数不一致，无法归入该组，与其它失败一样计入汇总
+                return result_data_entry{part.source_file_name,
+                    QString("分片总数不一致（同组为 %1 片，该分片标记为 %2 片）").arg(group.parts.size()).arg(part.sequence.total).toStdString()};
+            }
+
+            auto& slot = group.parts[static_cast<std::size_t>(part.sequence.index)];
+            if (!slot) {
+                ++group.received;
+                slot = std::move(part);
+            }
+            if (group.received != static_cast<int>(group.parts.size())) {
+                return std::nullopt;
+            }
+
+            QByteArray merged;
+            int size = 0;
+            for (const auto& p : group.parts) {
+                size += std::get<QByteArray>(p->data).size();
+            }
+            merged.reserve(size);
+            for (const auto& p : group.parts) {
+                merged += std::get<QByteArray>(p->data);
+            }
+
+            result_data_entry result{merged_source_name(group.parts.front()->source_file_name), std::move(merged)};
+            groups_.erase(id);
+            return result;
+        }
+
+        /**
+         * @brief 取出所有未凑齐的分组，每组生成一条错误结果
+         */
+        std::vector<result_data_entry> take_incomplete() {
+            std::lock_guard lock(mutex_);
+
+            std::vector<result_data_entry> results;
+            for (auto& [id, group] : groups_) {
+                QStringList missing;
+                QString source;
+                for (std::size_t i = 0; i < group.parts.size(); ++i) {
+                    if (group.parts[i]) {
+                        if (source.isEmpty())
+                            source = group.parts[i]->source_file_name;
+                    } else {
+                        missing.append(QString::number(i + 1));
+                    }
+                }
+                results.emplace_back(source,
+                    QString("分片不完整（共 %1 片），缺少第 %2 片").arg(group.parts.size()).arg(missing.join(", ")).toStdString());
+            }
+            groups_.clear();
+            return results;
+        }
+
+    private:
+        struct group {
+            std::vector<std::optional<result_data_entry>> parts;
+            int received = 0;
+        };
+
+        /**
+         * @brief 由第一个分片的文件名推出还原后的文件名，去掉生成时附加的 "_1" 序号
+         */
+        static QString merged_source_name(const QString& first_part) {
+            static const QRegularExpression part_suffix(R"(_\d+$)");
+
+            const QFileInfo info(first_part);
+            QString base = info.completeBaseName();
+            base.remove(part_suffix);
+            return info.dir().filePath(base + "." + info.suffix());
+        }
+
+        std::mutex mutex_;
+        std::map<std::uint32_t, group> groups_;
+    };
+
+    /**
+     * @brief 将一批解码结果中的分片重组，非分片条目保持原顺序不变
+     *
+     * 还原后的条目放在该组最后到达的分片的位置；缺片的分组以一条错误结果追加在末尾。
+     */
+    [[nodiscard]] inline std::vector<result_data_entry> reassemble_sequences(std::vector<result_data_entry> entries) {
+        sequence_assembler assembler;
+        std::vector<result_data_entry> results;
+        results.reserve(entries.size());
+
+        for (auto& entry : entries) {
+            if (entry.sequence.total <= 1 || !std::holds_alternative<QByteArray>(entry.data)) {
+                results.push_back(std::move(entry));
+                continue;
+            }
+            if (auto merged = assembler.add(std::move(entry))) {
+                results.push_back(std::move(*merged));
+            }
+        }
+
+        for (auto& incomplete : assembler.take_incomplete()) {
+            results.push_back(std::move(incomplete));
+        }
+        return results;
+    }
+
+} // namespace convert
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <QtConcurrent>
+#include <ZXing/ReadBarcode.h>
+#include <opencv2/opencv.hpp>
+
+#include "convert.h"
+#include "stage_timing.h"
+
+/**
+ * @file sheet_decode.h
+ * @brief 整页识别：一张图片中的所有条码逐个返回
+ *
+ * 小图直接交给 ZXing::ReadBarcodes；大图切成相互重叠的小块并行识别，
+ * 再把坐标换算回整页，按位置去掉重叠区域里被重复识别的条码。
+ * 重叠宽度需要大于页面上最大的条码边长，才能保证每个条码至少完整落在一个小块里。
+ */
+namespace convert {
+
+    /**
+     * @brief 分块参数
+     */
+    struct tile_config {
+        int tile_size = 2048; /**< 小块边长（像素），图片两边都不超过 tile_size + overlap 时不分块 */
+        int overlap   = 512;  /**< 相邻小块的重叠宽度（像素） */
+    };
+
+    /**
+     * @brief 整页识别得到的一个条码
+     */
+    struct sheet_symbol {
+        ZXing::Barcode barcode;
+        ZXing::PointI offset{}; /**< 所在小块左上角在整页中的坐标，barcode.position() 加上它即整页坐标 */
+
+        [[nodiscard]] ZXing::PointI center() const { return ZXing::Center(barcode.position()) + offset; }
+
+        /**
+         * @brief 条码的大致半径：四个角到中心的最大距离
+         */
+        [[nodiscard]] double radius() const {
+            const auto c = ZXing::Center(barcode.position());
+            double r     = 0;
+            for (const auto& corner : barcode.position()) {
+                r = std::max(r, ZXing::distance(corner, c));
+            }
+            return r;
+        }
+    };
+
+    namespace detail {
+        struct tile_job {
+            cv::Rect rect;
+            std::vector<sheet_symbol> symbols;
+        };
+
+        [[nodiscard]] inline std::vector<cv::Rect> make_tiles(int width, int height, const tile_config& config) {
+            const int step = std::max(1, config.tile_size - config.overlap);
+            const auto starts = [&](int length) {
+                std::vector<int> result{0};
+                // 最后一块贴齐边缘，不留下窄条
+                while (result.back() + config.tile_size < length) {
+                    result.push_back(std::min(result.back() + step, length - config.tile_size));
+                }
+                return result;
+            };
+
+            std::vector<cv::Rect> tiles;
+            for (const int y : starts(height)) {
+                for (const int x : starts(width)) {
+                    tiles.emplace_back(x, y, std::min(config.tile_size, width - x), std::min(config.tile_size, height - y));
+                }
+            }
+            return tiles;
+        }
+
+        /**
+         * @brief 同一内容、同一格式且中心距离小于半径的两个条码视为重叠区域里的同一个
+         */
+        [[nodiscard]] inline bool same_symbol(const sheet_symbol& a, const sheet_symbol& b) {
+            if (a.barcode.format() != b.barcode.format() || a.barcode.bytes() != b.barcode.bytes()) {
+                return false;
+            }
+            const double limit = std::max(a.radius(), b.radius());
+            return ZXing::distance(a.center(), b.center()) <= limit;
+        }
+
+        /**
+         * @brief 按阅读顺序（从上到下、同一行从左到右）排列，保证输出命名稳定
+         */
+        inline void sort_reading_order(std::vector<sheet_symbol>& symbols) {
+            std::ranges::sort(symbols, {}, [](const sheet_symbol& s) { return s.center().y; });
+
+            auto rowBegin = symbols.begin();
+            while (rowBegin != symbols.end()) {
+                // 中心纵坐标与行首相差不超过行首条码半径的，归为同一行
+                const double top   = rowBegin->center().y;
+                const double limit = rowBegin->radius();
+                auto rowEnd        = std::find_if(rowBegin, symbols.end(),
+                    [&](const sheet_symbol& s) { return s.center().y - top > limit; });
+                std::sort(rowBegin, rowEnd, [](const sheet_symbol& a, const sheet_symbol& b) { return a.center().x < b.center().x; });
+                rowBegin = rowEnd;
+            }
+        }
+    }
+
+    /**
+     * @brief 识别灰度图中的全部条码
+     * @param gray 单通道灰度图
+     * @param options ZXing 识别参数
+     * @param config 分块参数
+     * @return 去重并按阅读顺序排列的条码
+     */
+    [[nodiscard]] inline std::vector<sheet_symbol> read_sheet(const cv::Mat& gray, const ZXing::ReaderOptions& options,
+                                                             const tile_config& config = {}) {
+        const auto read = [&options](const cv::Mat& region) {
+            const timing::scoped_timer timer(timing::stage::zxing_decode);
+            const ZXing::ImageView view(region.data, region.cols, region.rows, ZXing::ImageFormat::Lum, static_cast<int>(region.step));
+            return ZXing::ReadBarcodes(view, options);
+        };
+
+        std::vector<sheet_symbol> symbols;
+        if (gray.cols <= config.tile_size + config.overlap && gray.rows <= config.tile_size + config.overlap) {
+            for (auto& barcode : read(gray)) {
+                symbols.push_back({std::move(barcode)});
+            }
+            detail::sort_reading_order(symbols);
+            return symbols;
+        }
+
+        std::vector<detail::tile_job> jobs;
+        for (const auto& rect : detail::make_tiles(gray.cols, gray.rows, config)) {
+            jobs.push_back({rect, {}});
+        }
+
+        // 小块之间互不依赖，调用线程本身也会参与执行，在线程池的工作线程里调用也不会死锁
+        QtConcurrent::blockingMap(jobs, [&](detail::tile_job& job) {
+            for (auto& barcode : read(gray(job.rect))) {
+                job.symbols.push_back({std::move(barcode), {job.rect.x, job.rect.y}});
+            }
+        });
+
+        for (auto& job : jobs) {
+            for (auto& symbol : job.symbols) {
+                if (std::ranges::none_of(symbols, [&](const sheet_symbol& kept) { return detail::same_symbol(kept, symbol); })) {
+                    symbols.push_back(std::move(symbol));
+                }
+            }
+        }
+        detail::sort_reading_order(symbols);
+        return symbols;
+    }
+
+} // namespace convert
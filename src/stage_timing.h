@@ -0,0 +1,255 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+/**
+ * @file stage_timing.h
+ * @brief 批处理各阶段的耗时直方图
+ *
+ * 工作线程在每个阶段前后各取一次 steady_clock，耗时按对数分桶累加到全局直方图中，只有几次 relaxed 原子加法，
+ * 不加锁、不分配内存，常开也不影响吞吐。批次开始时 reset，结束时 summarize 得到各阶段的次数、总耗时和分位数。
+ * 同一时间只统计一个批次；批次重叠时两者的耗时会记在一起。
+ */
+namespace timing {
+
+    /**
+     * @brief 计时的阶段
+     */
+    enum class stage : std::uint8_t {
+        read,         /**< 读取输入文件（QFile::readAll 或内存映射） */
+        compress,     /**< 压缩与解压 */
+        base64,       /**< Base64/Base45 等文本编码与解码 */
+        zxing_encode, /**< ZXing 编码出模块矩阵 */
+        rasterize,    /**< 模块矩阵光栅化为图片或缩略图 */
+        image_encode, /**< 图片编码为 PNG/PBM 等文件内容 */
+        write,        /**< 写出文件 */
+        imread,       /**< 图片解码（cv::imread/cv::imdecode） */
+        zxing_decode, /**< ZXing 识别 */
+        count_,
+    };
+
+    inline constexpr std::size_t stage_count = static_cast<std::size_t>(stage::count_);
+
+    /**
+     * @brief 结构化日志中的键名
+     */
+    [[nodiscard]] constexpr std::string_view stage_key(stage s) {
+        constexpr std::array<std::string_view, stage_count> keys{
+            "read", "compress", "base64", "zxing_encode", "rasterize", "image_encode", "write", "imread", "zxing_decode"};
+        return keys[static_cast<std::size_t>(s)];
+    }
+
+    /**
+     * @brief 界面中显示的名称
+     */
+    [[nodiscard]] constexpr std::string_view stage_label(stage s) {
+        constexpr std::array<std::string_view, stage_count> labels{
+            "读取文件", "压缩/解压", "Base64", "ZXing 编码", "光栅化", "图片编码", "写入文件", "图片解码", "ZXing 识别"};
+        return labels[static_cast<std::size_t>(s)];
+    }
+
+    /**
+     * @brief 一个阶段的统计结果，时间单位为纳秒
+     */
+    struct stage_summary {
+        stage s;
+        std::uint64_t count = 0;
+        std::uint64_t total = 0;
+        std::uint64_t p50   = 0;
+        std::uint64_t p90   = 0;
+        std::uint64_t p99   = 0;
+        std::uint64_t max   = 0;
+    };
+
+    /**
+     * @brief 无锁的对数直方图：每个 2 的幂区间再均分 4 格，分位数的相对误差不超过 12.5%
+     */
+    class histogram {
+    public:
+        void record(std::uint64_t ns) noexcept {
+            buckets_[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+            total_.fetch_add(ns, std::memory_order_relaxed);
+            auto max = max_.load(std::memory_order_relaxed);
+            while (ns > max && !max_.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+            }
+        }
+
+        void reset() noexcept {
+            for (auto& bucket : buckets_) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            total_.store(0, std::memory_order_relaxed);
+            max_.store(0, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] stage_summary summarize(stage s) const {
+            std::array<std::uint64_t, bucket_count> counts{};
+            std::uint64_t count = 0;
+            for (std::size_t i = 0; i < bucket_count; ++i) {
+                counts[i] = buckets_[i].load(std::memory_order_relaxed);
+                count += counts[i];
+            }
+            stage_summary summary{s, count, total_.load(std::memory_order_relaxed)};
+            summary.max = max_.load(std::memory_order_relaxed);
+            summary.p50 = percentile(counts, count, 0.50, summary.max);
+            summary.p90 = percentile(counts, count, 0.90, summary.max);
+            summary.p99 = percentile(counts, count, 0.99, summary.max);
+            return summary;
+        }
+
+    private:
+        static constexpr int sub_bits            = 2; /**< 每个 2 的幂区间分成 2^sub_bits 格 */
+        static constexpr std::size_t bucket_count = (64 - sub_bits + 1) << sub_bits;
+
+        [[nodiscard]] static std::size_t bucket_of(std::uint64_t ns) noexcept {
+            if (ns < (1u << sub_bits)) {
+                return static_cast<std::size_t>(ns);
+            }
+            const int msb = std::bit_width(ns) - 1;
+            const auto sub = (ns >> (msb - sub_bits)) & ((1u << sub_bits) - 1);
+            return (static_cast<std::size_t>(msb - sub_bits + 1) << sub_bits) + static_cast<std::size_t>(sub);
+        }
+
+        /**
+         * @brief 桶的代表值（区间中点）
+         */
+        [[nodiscard]] static std::uint64_t bucket_value(std::size_t bucket) noexcept {
+            if (bucket < (1u << sub_bits)) {
+                return bucket;
+            }
+            const int msb   = static_cast<int>(bucket >> sub_bits) + sub_bits - 1;
+            const auto sub   = static_cast<std::uint64_t>(bucket & ((1u << sub_bits) - 1));
+            const auto width = std::uint64_t{1} << (msb - sub_bits);
+            return (std::uint64_t{1} << msb) + sub * width + width / 2;
+        }
+
+        [[nodiscard]] static std::uint64_t percentile(const std::array<std::uint64_t, bucket_count>& counts, std::uint64_t count,
+                                                      double q, std::uint64_t max) {
+            if (count == 0) {
+                return 0;
+            }
+            const auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(q * static_cast<double>(count) + 0.5));
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < bucket_count; ++i) {
+                seen += counts[i];
+                if (seen >= rank) {
+                    return std::min(bucket_value(i), max);
+                }
+            }
+            return max;
+        }
+
+        std::array<std::atomic<std::uint64_t>, bucket_count> buckets_{};
+        std::atomic<std::uint64_t> total_{0};
+        std::atomic<std::uint64_t> max_{0};
+    };
+
+    /**
+     * @brief 全部阶段的直方图
+     */
+    class stage_timings {
+    public:
+        /**
+         * @brief 进程内共用的实例，工作线程通过 scoped_timer 记录到这里
+         */
+        [[nodiscard]] static stage_timings& global() {
+            static stage_timings instance;
+            return instance;
+        }
+
+        void record(stage s, std::uint64_t ns) noexcept { histograms_[static_cast<std::size_t>(s)].record(ns); }
+
+        void reset() noexcept {
+            for (auto& h : histograms_) {
+                h.reset();
+            }
+        }
+
+        /**
+         * @brief 有记录的阶段的统计，按阶段顺序
+         */
+        [[nodiscard]] std::vector<stage_summary> summarize() const {
+            std::vector<stage_summary> result;
+            for (std::size_t i = 0; i < stage_count; ++i) {
+                auto summary = histograms_[i].summarize(static_cast<stage>(i));
+                if (summary.count > 0) {
+                    result.push_back(summary);
+                }
+            }
+            return result;
+        }
+
+    private:
+        std::array<histogram, stage_count> histograms_;
+    };
+
+    /**
+     * @brief 结构化输出：{"阶段键名": {"count", "total_ms", "mean_us", "p50_us", "p90_us", "p99_us", "max_us"}, ...}
+     */
+    [[nodiscard]] inline nlohmann::json to_json(const std::vector<stage_summary>& summaries) {
+        const auto us = [](std::uint64_t ns) { return static_cast<double>(ns) / 1e3; };
+        nlohmann::json json = nlohmann::json::object();
+        for (const auto& s : summaries) {
+            json[std::string(stage_key(s.s))] = {
+                {"count", s.count},
+                {"total_ms", static_cast<double>(s.total) / 1e6},
+                {"mean_us", us(s.total / s.count)},
+                {"p50_us", us(s.p50)},
+                {"p90_us", us(s.p90)},
+                {"p99_us", us(s.p99)},
+                {"max_us", us(s.max)},
+            };
+        }
+        return json;
+    }
+
+    /**
+     * @brief 作用域计时：构造时开始，析构或 stop 时记录到 stage_timings::global()
+     */
+    class scoped_timer {
+    public:
+        explicit scoped_timer(stage s) noexcept : stage_(s), start_(std::chrono::steady_clock::now()) {}
+        ~scoped_timer() { stop(); }
+
+        scoped_timer(const scoped_timer&)            = delete;
+        scoped_timer& operator=(const scoped_timer&) = delete;
+
+        /**
+         * @brief 提前结束计时，阶段只占作用域的前一部分时使用；重复调用无效
+         */
+        void stop() noexcept {
+            if (!running_) {
+                return;
+            }
+            running_           = false;
+            const auto elapsed = std::chrono::steady_clock::now() - start_;
+            stage_timings::global().record(stage_,
+                static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        }
+
+    private:
+        stage stage_;
+        bool running_ = true;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    /**
+     * @brief 计时执行 f 并返回其结果，用于只包住一个表达式的场合
+     */
+    template <typename F>
+    decltype(auto) timed(stage s, F&& f) {
+        const scoped_timer timer(s);
+        return f();
+    }
+
+} // namespace timing
@@ -3,6 +3,9 @@
 
 #ifdef _WIN32
 #include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
 #endif
 
 #ifdef __linux__
@@ -64,30 +67,68 @@ namespace sysinfo {
 #endif
         }
 
+        inline double getPeakRSS_Bytes()
+        {
+#ifdef _WIN32
+
+            PROCESS_MEMORY_COUNTERS counters;
+            if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+                return static_cast<double>(counters.PeakWorkingSetSize);   // Bytes
+            }
+            return 0;
+
+#else
+
+            rusage usage{};
+            if (getrusage(RUSAGE_SELF, &usage) != 0) {
+                return 0;
+            }
+#if defined(__APPLE__) && defined(__MACH__)
+            return static_cast<double>(usage.ru_maxrss);          // Bytes
+#else
+            return static_cast<double>(usage.ru_maxrss) * 1024;   // kB → Bytes
+#endif
+
+#endif
+        }
+
+        template <typename T>
+        double convertBytes(double bytes)
+        {
+            if constexpr (std::is_same_v<T, Bytes>) {
+                return bytes;
+            }
+            else if constexpr (std::is_same_v<T, KB>) {
+                return bytes / 1024;
+            }
+            else if constexpr (std::is_same_v<T, MB>) {
+                return bytes / (1024ull * 1024ull);
+            }
+            else if constexpr (std::is_same_v<T, GB>) {
+                return bytes / (1024ull * 1024ull * 1024ull);
+            }
+            else {
+                static_assert(!sizeof(T), "Unknown unit type");
+                return 0;
+            }
+        }
+
     }
 
 
     template <typename T = KB>
     double getSystemRAM()
     {
-        const double bytes = detail::getSystemRAM_Bytes();
+        return detail::convertBytes<T>(detail::getSystemRAM_Bytes());
+    }
 
-        if constexpr (std::is_same_v<T, Bytes>) {
-            return bytes;
-        }
-        else if constexpr (std::is_same_v<T, KB>) {
-            return bytes / 1024;
-        }
-        else if constexpr (std::is_same_v<T, MB>) {
-            return bytes / (1024ull * 1024ull);
-        }
-        else if constexpr (std::is_same_v<T, GB>) {
-            return bytes / (1024ull * 1024ull * 1024ull);
-        }
-        else {
-            static_assert(!sizeof(T), "Unknown unit type");
-            return 0;
-        }
+    /**
+     * @brief 当前进程的峰值常驻内存
+     */
+    template <typename T = KB>
+    double getPeakRSS()
+    {
+        return detail::convertBytes<T>(detail::getPeakRSS_Bytes());
     }
 
     inline unsigned int getCPUCoreCount() {
@@ -0,0 +1,1144 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QList>
+#include <QString>
+#include <QtEndian>
+#include <SimpleBase45.h>
+#include <SimpleBase64.h>
+#include <spdlog/spdlog.h>
+
+#include "barcode_cache.h"
+#include "batch_dedup.h"
+#include "batch_journal.h"
+#include "compression.h"
+#include "convert.h"
+#include "image_writer.h"
+#include "stage_timing.h"
+#include "overload.h"
+#include "pipeline.h"
+#include "sequence.h"
+#include "sheet_decode.h"
+
+/**
+ * @namespace workers
+ * @brief 批处理任务的执行单元（生成、解码、保存），供图形界面和命令行工具共用
+ *
+ * 每个 worker 都是可以直接交给 QtConcurrent::mapped 的函数对象，不依赖任何界面控件。
+ * 需要分阶段执行时，load_*_worker 负责读取，encode_worker / write_worker 负责保存的编码与写入，
+ * 生成和识别的 worker 另有接受已读入内容的重载，组合方式见 pipeline.h。
+ */
+namespace workers {
+
+    /**
+     * @brief 决定一段负载写入条码的方式
+     *
+     * 勾选原始字节时直接使用字节模式；勾选 Base64 时按 packing 选择文本编码，自动模式下 QR 系列改用 Base45，
+     * 负载本身只含字母数字模式字符时原样写入。未勾选 Base64 而内容不是合法 UTF-8（二进制文件、GBK 文本等）时，
+     * 也自动改用字节模式，不再把非法序列替换成 U+FFFD。一维码不支持任意字节，保持原有方式。
+     */
+    [[nodiscard]] inline convert::payload_mode choose_payload_mode(std::span<const std::uint8_t> bytes, ZXing::BarcodeFormat format,
+                                                                   bool useBase64, bool binary,
+                                                                   convert::text_packing packing = convert::text_packing::automatic) {
+        if (binary && convert::supports_binary(format)) {
+            return convert::payload_mode::binary;
+        }
+        if (useBase64) {
+            switch (packing) {
+            case convert::text_packing::base64:
+                return convert::payload_mode::base64;
+            case convert::text_packing::base45:
+                return convert::payload_mode::base45;
+            case convert::text_packing::automatic:
+                if (!convert::supports_alphanumeric(format)) {
+                    return convert::payload_mode::base64;
+                }
+                return convert::is_alphanumeric(bytes) ? convert::payload_mode::alphanumeric : convert::payload_mode::base45;
+            }
+        }
+        if (!convert::supports_binary(format)) {
+            return convert::payload_mode::text;
+        }
+        return convert::is_valid_utf8(bytes) ? convert::payload_mode::text : convert::payload_mode::binary;
+    }
+
+    /**
+     * @brief 是否在编码前尝试压缩：只对本来就按二进制处理的写入方式压缩，原样写入的模式不压缩
+     */
+    [[nodiscard]] inline bool compressible(convert::payload_mode mode) {
+        return mode == convert::payload_mode::base64 || mode == convert::payload_mode::base45 || mode == convert::payload_mode::binary;
+    }
+
+    /**
+     * @brief 该写入方式的内容是否全部在字母数字字符集内，分片头需要随之改用字母数字形式
+     */
+    [[nodiscard]] inline bool alphanumeric_content(convert::payload_mode mode) {
+        return mode == convert::payload_mode::base45 || mode == convert::payload_mode::alphanumeric;
+    }
+
+    /**
+     * @brief 按写入方式把分片头和负载拼成交给 ZXing 的宽字符串
+     * @param header 分片头，没有分片时为空
+     */
+    [[nodiscard]] inline std::wstring make_payload_text(std::string_view header, std::span<const std::uint8_t> payload,
+                                                       convert::payload_mode mode) {
+        const timing::scoped_timer timer(timing::stage::base64);
+        std::wstring text(header.begin(), header.end());
+        switch (mode) {
+        case convert::payload_mode::base64:
+            SimpleBase64::encode_append(text, payload.data(), payload.size());
+            break;
+        case convert::payload_mode::binary:
+            convert::append_bytes_as_wide(text, payload);
+            break;
+        case convert::payload_mode::base45:
+            text.push_back(convert::base45_marker);
+            SimpleBase45::encode_append(text, payload.data(), payload.size());
+            break;
+        case convert::payload_mode::alphanumeric:
+            text.push_back(convert::alphanumeric_marker);
+            convert::append_bytes_as_wide(text, payload);
+            break;
+        case convert::payload_mode::text:
+            convert::append_utf8_as_wide(text, {reinterpret_cast<const char*>(payload.data()), payload.size()});
+            break;
+        }
+        return text;
+    }
+
+    /**
+     * @brief 编码出模块矩阵，光栅化推迟到显示或保存时
+     */
+    [[nodiscard]] inline convert::module_matrix encode_payload_text(const std::wstring& text, convert::payload_mode mode,
+                                                                    const convert::QRcode_create_config& config) {
+        const timing::scoped_timer timer(timing::stage::zxing_encode);
+        return mode == convert::payload_mode::binary ? convert::binary_to_QRCode_modules(text, config)
+                                                     : convert::byte_to_QRCode_modules(text, config);
+    }
+
+    /**
+     * @brief 为生成结果附上缩略图，在工作线程中完成，界面线程只需转换为 QPixmap
+     * @param size 缩略图边长，不大于 0 时不生成（命令行工具不需要缩略图）
+     */
+    inline void attach_thumbnail(convert::result_data_entry& res, int size) {
+        if (size <= 0) {
+            return;
+        }
+        if (const auto* modules = std::get_if<convert::module_matrix>(&res.data)) {
+            const timing::scoped_timer timer(timing::stage::rasterize);
+            res.thumbnail = modules->thumbnail(size);
+        }
+    }
+
+    /**
+     * @brief 直接文本生成条码
+     */
+    struct generate_text_worker {
+        using result_type = convert::result_data_entry;
+
+        bool useBase64;
+        convert::QRcode_create_config config;
+        convert::barcode_cache* cache = nullptr; /**< 可选的条码缓存 */
+        bool compress                 = false;   /**< 编码前先尝试压缩，仅在 Base64 和原始字节模式下生效 */
+        bool binary                   = false;   /**< 以原始字节模式写入，优先于 Base64 */
+        convert::text_packing packing = convert::text_packing::automatic; /**< 勾选 Base64 时的文本编码 */
+        int thumbnailSize             = 0;       /**< 同时生成的缩略图边长，0 表示不生成 */
+
+        convert::result_data_entry operator()(const QString& textInput) const {
+            auto res = generate(textInput);
+            attach_thumbnail(res, thumbnailSize);
+            return res;
+        }
+
+    private:
+        convert::result_data_entry generate(const QString& textInput) const {
+            convert::result_data_entry res;
+            // 对于直接文本模式，source_file_name 可以设为空，或者设为一个标识字符串
+            // 这样在保存文件时，会默认生成 "qrcode.png" 之类的名字
+            res.source_file_name = "raw_text_input";
+
+            try {
+                QByteArray data = textInput.toUtf8();
+                const std::span<const std::uint8_t> bytes{
+                    reinterpret_cast<const std::uint8_t*>(data.constData()), static_cast<std::size_t>(data.size())};
+
+                const auto mode = choose_payload_mode(bytes, config.format, useBase64, binary, packing);
+                const bool pack = compress && compressible(mode);
+
+                std::string key;
+                if (cache) {
+                    key = convert::barcode_cache::make_key(bytes, config, mode, pack);
+                    if (auto hit = cache->find(key)) {
+                        res.data = std::move(*hit);
+                        return res;
+                    }
+                }
+
+                // 与文件生成相同，直接写入交给 ZXing 的宽字符串；不压缩时也要转义以魔数开头的数据
+                if (pack) {
+                    if (auto packed = timing::timed(timing::stage::compress, [&] { return convert::compress_payload(bytes); })) {
+                        data = std::move(*packed);
+                    }
+                } else if (compressible(mode)) {
+                    if (auto escaped = convert::escape_payload(bytes)) {
+                        data = std::move(*escaped);
+                    }
+                }
+                const std::span<const std::uint8_t> payload{
+                    reinterpret_cast<const std::uint8_t*>(data.constData()), static_cast<std::size_t>(data.size())};
+                auto modules = encode_payload_text(make_payload_text({}, payload, mode), mode, config);
+
+                if (!modules.empty()) {
+                    if (cache) {
+                        cache->store(key, modules);
+                    }
+                    res.data = std::move(modules);
+                } else {
+                    res.data = std::string("生成图片失败");
+                }
+            } catch (const std::exception& e) {
+                res.data.emplace<std::string>(e.what());
+            }
+            return res;
+        }
+    };
+
+    /**
+     * @brief 文件生成任务：整个文件，或超出单个条码容量时文件的一个分片
+     */
+    struct file_part {
+        QString path;
+        convert::sequence_info sequence{}; /**< total 为 0 表示整个文件 */
+        qint64 offset = 0;                 /**< 分片在文件中的起始字节 */
+        qint64 length = -1;                /**< 分片字节数，-1 表示读到文件末尾 */
+        QString relativeDir;               /**< 相对于枚举根目录的子目录，见 walk_inputs；结果保存时保持层级 */
+    };
+
+    /**
+     * @brief 文本模式下分片读取时额外向后多读的字节数，用于补全被截断的 UTF-8 字符
+     */
+    inline constexpr qint64 utf8_lookahead = 3;
+
+    /**
+     * @brief 由文件路径、内容和拆分参数算出分片头中的分组 id（SHA-256 的前 32 位）
+     *
+     * 输入和参数不变时每次生成的分片头相同，条码缓存能够命中，续跑时也能接着生成只完成了一部分的文件；
+     * 路径计入摘要，内容相同的两个文件同批解码时不会混成一组。需要把整个文件读一遍，只在确实要拆分时调用。
+     */
+    [[nodiscard]] inline std::uint32_t sequence_group_id(const QString& path, const QByteArray& settings) {
+        QCryptographicHash hash(QCryptographicHash::Sha256);
+        hash.addData(QFileInfo(path).absoluteFilePath().toUtf8());
+        hash.addData(settings);
+        if (QFile file(path); file.open(QIODevice::ReadOnly)) {
+            constexpr qint64 chunk = 1 << 20;
+            for (QByteArray bytes = file.read(chunk); !bytes.isEmpty(); bytes = file.read(chunk)) {
+                hash.addData(bytes);
+            }
+        }
+        return qFromBigEndian<quint32>(hash.result().constData());
+    }
+
+    /**
+     * @brief 按文件大小规划生成任务，超出单个条码容量的文件拆成若干分片并行生成
+     *
+     * Base64 模式下每片字节数取 3 的倍数；原始字节模式下整片写满；
+     * 文本模式下分片边界会在读取时对齐到 UTF-8 字符边界（见 align_utf8_part）。
+     *
+     * Base45 模式下按字母数字模式的容量、每 2 字节 3 个字符规划（自动模式原样写入时只会更短）。
+     * 字节模式（原始字节、文本）预留 ECI 段；可压缩的负载恰好以压缩魔数开头时会多出 stored 头，也一并预留。
+     *
+     * 需要拆分的文件会整个读一遍以算出分组 id（见 sequence_group_id），不拆分的文件只读取大小。
+     *
+     * @param binary 原始字节模式，优先于 Base64；调用方须已按 supports_binary 过滤
+     * @param packing 勾选 Base64 时的文本编码，须与生成时一致
+     */
+    [[nodiscard]] inline QList<file_part> plan_file_parts(const QString& path, ZXing::BarcodeFormat format, bool useBase64,
+                                                          bool binary = false,
+                                                          convert::text_packing packing = convert::text_packing::automatic) {
+        const bool packed  = useBase64 && !binary;
+        const bool base45  = packed
+            && (packing == convert::text_packing::base45
+                || (packing == convert::text_packing::automatic && convert::supports_alphanumeric(format)));
+        const bool base64  = packed && !base45;
+        const int capacity = convert::symbol_capacity(format, base45);
+        const qint64 size  = QFileInfo(path).size();
+        const qint64 eci    = packed ? 0 : convert::eci_header_reserve;
+        const qint64 stored = static_cast<qint64>(convert::compression_header_size);
+        // Base45 多出 1 个字符的标记
+        const qint64 text  = base64 ? (size + stored + 2) / 3 * 4
+                           : base45 ? (size + stored + 1) / 2 * 3 + 1
+                                    : size + stored + eci;
+        if (capacity <= convert::sequence_header_reserve + eci + stored || text <= capacity) {
+            return {file_part{path}};
+        }
+
+        const qint64 budget   = capacity - convert::sequence_header_reserve - eci;
+        // 文本模式预留 utf8_lookahead 字节，分片末尾可能向后延伸到完整的 UTF-8 字符
+        const qint64 perPart  = (base64 ? budget / 4 * 3
+                                : base45 ? (budget - 1) / 3 * 2
+                                : binary ? budget
+                                         : budget - utf8_lookahead)
+                              - stored;
+        const int total       = static_cast<int>((size + perPart - 1) / perPart);
+        const std::uint32_t id = sequence_group_id(path,
+            QString("%1;%2;%3;%4").arg(static_cast<int>(format)).arg(binary ? "binary" : base64 ? "base64" : base45 ? "base45" : "text")
+                .arg(perPart).arg(total).toUtf8());
+
+        QList<file_part> parts;
+        parts.reserve(total);
+        for (int i = 0; i < total; ++i) {
+            const qint64 offset = i * perPart;
+            parts.append({path, {id, i, total}, offset, std::min(perPart, size - offset)});
+        }
+        return parts;
+    }
+
+    /**
+     * @class mapped_region
+     * @brief 以内存映射方式只读打开文件的一段，无法映射时（管道、空文件等）退回普通读取
+     *
+     * 映射期间不产生任何自有缓冲区，数据直接由页缓存提供。
+     */
+    class mapped_region {
+    public:
+        /**
+         * @param length 字节数，-1 表示到文件末尾
+         */
+        bool open(const QString& path, qint64 offset = 0, qint64 length = -1) {
+            file_.setFileName(path);
+            if (!file_.open(QIODevice::ReadOnly)) {
+                return false;
+            }
+            if (file_.isSequential()) {
+                fallback_ = file_.readAll();
+                bytes_    = {reinterpret_cast<const std::uint8_t*>(fallback_.constData()), static_cast<std::size_t>(fallback_.size())};
+                return true;
+            }
+
+            const qint64 size      = file_.size();
+            offset                 = std::clamp<qint64>(offset, 0, size);
+            const qint64 available = size - offset;
+            length                 = length < 0 ? available : std::min(length, available);
+            if (length == 0) {
+                return true;
+            }
+
+            if (const uchar* mapped = file_.map(offset, length)) {
+                bytes_ = {mapped, static_cast<std::size_t>(length)};
+                return true;
+            }
+            if (!file_.seek(offset)) {
+                return false;
+            }
+            fallback_ = file_.read(length);
+            bytes_    = {reinterpret_cast<const std::uint8_t*>(fallback_.constData()), static_cast<std::size_t>(fallback_.size())};
+            return true;
+        }
+
+        [[nodiscard]] std::span<const std::uint8_t> bytes() const noexcept { return bytes_; }
+
+        /**
+         * @brief 提前解除映射并关闭文件，之后 bytes() 为空
+         */
+        void close() {
+            bytes_ = {};
+            file_.close();
+            fallback_.clear();
+        }
+
+    private:
+        QFile file_;
+        QByteArray fallback_;
+        std::span<const std::uint8_t> bytes_;
+    };
+
+    /**
+     * @brief 将分片首尾都向后移动到 UTF-8 字符起始处，相邻分片据此无缝衔接
+     * @param window 从分片起点开始、比分片多 utf8_lookahead 字节的数据
+     */
+    [[nodiscard]] inline std::span<const std::uint8_t> align_utf8_part(std::span<const std::uint8_t> window, const file_part& part) {
+        const auto continuation = [window](std::size_t i) { return (window[i] & 0xC0) == 0x80; };
+
+        std::size_t begin = 0;
+        if (part.offset > 0) {
+            while (begin < utf8_lookahead && begin < window.size() && continuation(begin))
+                ++begin;
+        }
+        std::size_t end = std::min<std::size_t>(static_cast<std::size_t>(part.length), window.size());
+        while (end < window.size() && continuation(end))
+            ++end;
+        return window.subspan(begin, end - begin);
+    }
+
+    /**
+     * @brief 生成时文本模式的分片需要对齐到 UTF-8 字符边界
+     */
+    [[nodiscard]] inline bool aligns_utf8(const file_part& part, bool useBase64, bool binary) {
+        return part.sequence.total > 0 && !useBase64 && !binary;
+    }
+
+    /**
+     * @brief 流水线读取阶段的产物：文件（或其中一个分片）的内容已读入内存
+     */
+    struct loaded_part {
+        file_part part;
+        QByteArray bytes;   /**< 分片内容，需要对齐 UTF-8 时多读 utf8_lookahead 字节 */
+        bool ok = false;    /**< 打开或读取失败时为 false */
+        std::string digest; /**< 分片本身内容的 SHA-256，只在 load_part_worker::digest 为 true 时计算 */
+        batch_journal::input_stamp stamp; /**< 读取前文件的大小和修改时间，与 digest 同时取得 */
+
+        /**
+         * @brief 分片本身的字节，不含向后多读的部分
+         */
+        [[nodiscard]] std::span<const std::uint8_t> part_bytes() const {
+            const qint64 size = part.sequence.total > 0 ? std::min<qint64>(part.length, bytes.size()) : bytes.size();
+            return {reinterpret_cast<const std::uint8_t*>(bytes.constData()), static_cast<std::size_t>(size)};
+        }
+    };
+
+    /**
+     * @brief 读取阶段：在 I/O 线程中把分片读入内存，读取范围与 generate_file_worker 直接映射文件时相同
+     */
+    struct load_part_worker {
+        bool useBase64;
+        bool binary = false; /**< 须与 generate_file_worker 的参数一致 */
+        bool digest = false; /**< 读入后在 I/O 线程中顺带计算内容摘要，供批次去重和续跑日志使用 */
+
+        loaded_part operator()(const file_part& part) const {
+            loaded_part loaded{part};
+            const timing::scoped_timer timer(timing::stage::read);
+            if (digest) {
+                // 先取大小和修改时间再读内容，读取期间文件被改时续跑会因时间不符而重新核对哈希
+                loaded.stamp = batch_journal::input_stamp::of(part.path);
+            }
+            QFile file(part.path);
+            if (!file.open(QIODevice::ReadOnly) || !file.seek(part.offset)) {
+                return loaded;
+            }
+            if (part.sequence.total > 0) {
+                loaded.bytes = file.read(part.length + (aligns_utf8(part, useBase64, binary) ? utf8_lookahead : 0));
+            } else {
+                loaded.bytes = file.readAll();
+            }
+            loaded.ok = file.error() == QFileDevice::NoError;
+            if (digest && loaded.ok) {
+                loaded.digest = batch_journal::hash_bytes(loaded.part_bytes());
+            }
+            return loaded;
+        }
+    };
+
+    /**
+     * @brief 读取文件内容（或其中一个分片）并生成条码
+     */
+    struct generate_file_worker {
+        using result_type = convert::result_data_entry;
+
+        int reqWidth;
+        int reqHeight;
+        bool useBase64;
+        ZXing::BarcodeFormat format;
+        convert::barcode_cache* cache = nullptr; /**< 可选的条码缓存，命中时跳过编码 */
+        bool compress                 = false;   /**< 编码前先尝试压缩，仅在 Base64 和原始字节模式下生效 */
+        bool binary                   = false;   /**< 以原始字节模式写入，优先于 Base64；须与 plan_file_parts 的参数一致 */
+        convert::text_packing packing = convert::text_packing::automatic; /**< 勾选 Base64 时的文本编码，须与 plan_file_parts 的参数一致 */
+        int thumbnailSize             = 0;       /**< 同时生成的缩略图边长，0 表示不生成 */
+        std::shared_ptr<batch_dedup<convert::result_data_entry>> dedup; /**< 可选的批次内去重，内容相同的整文件只编码一次 */
+
+        convert::result_data_entry operator()(const QString& filePath) const {
+            return (*this)(file_part{filePath});
+        }
+
+        convert::result_data_entry operator()(const file_part& part) const {
+            return generate(part);
+        }
+
+        /**
+         * @brief 流水线的转换阶段：内容已由 load_part_worker 读入内存
+         */
+        convert::result_data_entry operator()(const loaded_part& loaded) const {
+            if (!loaded.ok) {
+                return open_failed(loaded.part);
+            }
+            return encode_once(loaded.part,
+                {reinterpret_cast<const std::uint8_t*>(loaded.bytes.constData()), static_cast<std::size_t>(loaded.bytes.size())},
+                loaded.digest, [] {});
+        }
+
+    private:
+        static convert::result_data_entry open_failed(const file_part& part) {
+            convert::result_data_entry res;
+            res.source_file_name = part.path;
+            res.sequence         = part.sequence;
+            res.relative_dir     = part.relativeDir;
+            res.data             = std::string("无法打开文件: ") + part.path.toStdString();
+            return res;
+        }
+
+        convert::result_data_entry generate(const file_part& part) const {
+            // 文件内容通过内存映射直接交给 Base64/UTF-8 转换，整个流程只持有一份自有缓冲区：交给 ZXing 的宽字符串
+            const bool split = part.sequence.total > 0;
+            // 映射本身很快，页面在后面第一次访问时才真正读盘，这部分时间计入 Base64
+            mapped_region region;
+            if (!timing::timed(timing::stage::read, [&] {
+                    return region.open(part.path, part.offset,
+                        split ? part.length + (aligns_utf8(part, useBase64, binary) ? utf8_lookahead : 0) : -1);
+                })) {
+                return open_failed(part);
+            }
+            return encode_once(part, region.bytes(), {}, [&region] { region.close(); });
+        }
+
+        /**
+         * @brief 启用去重时内容相同的整文件只编码一次，其余文件复用结果（连同缩略图），只换上自己的文件名
+         *
+         * 分片不参与去重：分组 id 含文件路径，各文件不同，共享结果会让两个文件的分片混成一组。
+         *
+         * @param digest 读取时已算好的内容摘要，为空时在这里计算
+         */
+        template <typename Release>
+        convert::result_data_entry encode_once(const file_part& part, std::span<const std::uint8_t> window, std::string digest,
+                                               Release&& release) const {
+            const auto compute = [&] {
+                auto res = encode(part, window, release);
+                res.relative_dir = part.relativeDir;
+                attach_thumbnail(res, thumbnailSize);
+                return res;
+            };
+            if (!dedup || part.sequence.total > 0) {
+                return compute();
+            }
+            if (digest.empty()) {
+                digest = batch_journal::hash_bytes(window);
+            }
+            auto [res, shared] = dedup->share(digest, window.size(), compute);
+            if (shared) {
+                res.source_file_name = part.path;
+                res.sequence         = part.sequence;
+                res.relative_dir     = part.relativeDir;
+            }
+            return std::move(res);
+        }
+
+        /**
+         * @param window 分片内容（需要对齐 UTF-8 时多出 utf8_lookahead 字节）
+         * @param release 负载已转换为宽字符串、不再需要 window 时调用，用于提前释放映射
+         */
+        template <typename Release>
+        convert::result_data_entry encode(const file_part& part, std::span<const std::uint8_t> window, Release&& release) const {
+            const QString& filePath = part.path;
+            try {
+                convert::result_data_entry res;
+                res.source_file_name = filePath;
+                res.sequence         = part.sequence;
+
+                const bool split = part.sequence.total > 0;
+                const auto bytes = aligns_utf8(part, useBase64, binary) ? align_utf8_part(window, part) : window;
+
+                const convert::QRcode_create_config config{
+                    .target_width = reqWidth, .target_height = reqHeight, .format = format, .margin = 1};
+
+                const auto mode = choose_payload_mode(bytes, format, useBase64, binary, packing);
+                const bool pack = compress && compressible(mode);
+                const std::string header = split ? convert::make_sequence_header(part.sequence, alphanumeric_content(mode)) : std::string{};
+
+                std::string key;
+                if (cache) {
+                    // 分片头里的分组 id 随文件路径和内容而变，一并计入键，避免拼出 id 不一致的分片
+                    key = convert::barcode_cache::make_key(bytes, config, mode, pack, header);
+                    if (auto hit = cache->find(key)) {
+                        res.data = std::move(*hit);
+                        return res;
+                    }
+                }
+
+                // 分片各自独立压缩，解码时每片先解压再拼接
+                // 不压缩时也要转义以魔数开头的数据，解码时可压缩模式的负载总会检查压缩头
+                const auto packed = pack ? timing::timed(timing::stage::compress, [&] { return convert::compress_payload(bytes); })
+                                  : compressible(mode) ? convert::escape_payload(bytes)
+                                                       : std::nullopt;
+                const auto payload = packed
+                    ? std::span<const std::uint8_t>{reinterpret_cast<const std::uint8_t*>(packed->constData()),
+                          static_cast<std::size_t>(packed->size())}
+                    : bytes;
+                const std::wstring text = make_payload_text(header, payload, mode);
+                release();
+
+                auto modules = encode_payload_text(text, mode, config);
+
+                if (!modules.empty()) {
+                    if (cache) {
+                        cache->store(key, modules);
+                    }
+                    res.data = std::move(modules);
+                } else {
+                    res.data = std::string("生成图片失败");
+                }
+
+                return res;
+            } catch (const std::exception& e) {
+                convert::result_data_entry res;
+                res.source_file_name = filePath;
+                res.sequence         = part.sequence;
+                res.data.emplace<std::string>(e.what());
+                return res;
+            }
+        }
+    };
+
+    /**
+     * @brief 将识别出的条码内容还原为原始字节：取出分片头、按标记做 Base64/Base45 解码、解压
+     *
+     * 原始字节模式的条码（content.binary）不论是否勾选 Base64 都不再解码，直接解压。
+     */
+    [[nodiscard]] inline convert::result_data_entry decode_payload(QString path, convert::result_i2t content, bool useBase64) {
+        std::string& text = content.text;
+        // 分片头在 Base64 之外，先取出再解码分片内容
+        const auto sequence = convert::take_sequence_header(text);
+
+        // 直接解码进结果缓冲区，不经过中间的 std::vector
+        QByteArray payload;
+        timing::scoped_timer decodeTimer(timing::stage::base64);
+        if (useBase64 && !content.binary && text.starts_with(convert::base45_marker)) {
+            payload.resize(static_cast<int>(SimpleBase45::max_decoded_size(text.size() - 1)));
+            const auto size = SimpleBase45::decode_to(reinterpret_cast<std::uint8_t*>(payload.data()), text.data() + 1, text.size() - 1);
+            payload.resize(static_cast<int>(size));
+        } else if (useBase64 && !content.binary && text.starts_with(convert::alphanumeric_marker)) {
+            payload = QByteArray(text.data() + 1, static_cast<int>(text.size() - 1));
+        } else if (useBase64 && !content.binary) {
+            payload.resize(static_cast<int>(SimpleBase64::max_decoded_size(text.size())));
+            const auto size = SimpleBase64::decode_into(
+                text, {reinterpret_cast<std::uint8_t*>(payload.data()), static_cast<std::size_t>(payload.size())});
+            payload.resize(static_cast<int>(size));
+        } else {
+            payload = QByteArray(text.data(), static_cast<int>(text.size()));
+        }
+        decodeTimer.stop();
+        // 生成时压缩过的负载带有压缩头，这里透明解压
+        if ((useBase64 || content.binary)
+            && !timing::timed(timing::stage::compress, [&] { return convert::decompress_payload(payload); })) {
+            return {std::move(path), std::string{"压缩数据已损坏或压缩格式不受支持"}};
+        }
+        convert::result_data_entry entry{std::move(path), std::move(payload)};
+        entry.sequence = sequence.value_or(convert::sequence_info{});
+        return entry;
+    }
+
+    /**
+     * @brief 流水线读取阶段的产物：整个图片文件的内容
+     */
+    struct loaded_file {
+        QString path;
+        QByteArray bytes; /**< 读取失败时为空 */
+    };
+
+    /**
+     * @brief 读取阶段：在 I/O 线程中把整个文件读入内存，识别时不再访问磁盘
+     */
+    struct load_file_worker {
+        loaded_file operator()(const QString& path) const {
+            const timing::scoped_timer timer(timing::stage::read);
+            QFile file(path);
+            return {path, file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray{}};
+        }
+    };
+
+    /**
+     * @brief 识别图片中的条码并还原为原始字节
+     */
+    struct decode_file_worker {
+        using result_type = convert::result_data_entry;
+
+        bool useBase64;
+        convert::decode_profile profile{}; /**< 限定识别的格式与强度 */
+
+        convert::result_data_entry operator()(QString path) const {
+            const auto file_path = path.toLocal8Bit().toStdString();
+            return decode(std::move(path), [&] { return convert::QRcode_to_byte(file_path, profile); });
+        }
+
+        /**
+         * @brief 流水线的转换阶段：文件内容已由 load_file_worker 读入内存
+         */
+        convert::result_data_entry operator()(const loaded_file& file) const {
+            return decode(file.path, [&] { return convert::QRcode_to_byte(file.bytes, profile); });
+        }
+
+    private:
+        template <typename Recognize>
+        convert::result_data_entry decode(QString path, Recognize&& recognize) const {
+            try {
+                switch (auto rst = recognize(); rst.err) {
+                case convert::result_i2t::empty_img:
+                    spdlog::error("cv::imread 无法加载图片文件: {}", path.toStdString());
+                    return {std::move(path), QString{"无法加载图片文件: %1"}.arg(path).toStdString()};
+                case convert::result_i2t::invalid_qrcode:
+                    return {std::move(path), std::string{"无法识别条码或条码格式不正确"}};
+                default:
+                    return decode_payload(std::move(path), std::move(rst), useBase64);
+                }
+            } catch (const std::exception& e) {
+                return {std::move(path), QString("解码失败:\n%1").arg(e.what()).toStdString()};
+            }
+        }
+    };
+
+    /**
+     * @brief 整页识别：一张图片中的每个条码各自还原为一条结果
+     *
+     * 多个条码时结果按阅读顺序编号，来源名为 "<图片名>_<序号>.<扩展名>"，保存时互不覆盖。
+     */
+    struct decode_sheet_worker {
+        using result_type = std::vector<convert::result_data_entry>;
+
+        bool useBase64;
+        convert::decode_profile profile{};
+        convert::tile_config tiles{};
+
+        std::vector<convert::result_data_entry> operator()(QString path) const {
+            return decode(path, [&] { return cv::imread(path.toLocal8Bit().toStdString(), cv::IMREAD_GRAYSCALE); });
+        }
+
+        /**
+         * @brief 流水线的转换阶段：文件内容已由 load_file_worker 读入内存
+         */
+        std::vector<convert::result_data_entry> operator()(const loaded_file& file) const {
+            return decode(file.path, [&] {
+                return file.bytes.isEmpty() ? cv::Mat{}
+                                            : cv::imdecode(cv::Mat(1, static_cast<int>(file.bytes.size()), CV_8U,
+                                                               const_cast<char*>(file.bytes.constData())),
+                                                  cv::IMREAD_GRAYSCALE);
+            });
+        }
+
+    private:
+        template <typename Load>
+        std::vector<convert::result_data_entry> decode(const QString& path, Load&& load) const {
+            try {
+                const cv::Mat gray = timing::timed(timing::stage::imread, load);
+                if (gray.empty()) {
+                    spdlog::error("cv::imread 无法加载图片文件: {}", path.toStdString());
+                    return {{path, QString{"无法加载图片文件: %1"}.arg(path).toStdString()}};
+                }
+
+                const auto options = profile.reader_options();
+                auto symbols       = convert::read_sheet(gray, options, tiles);
+                if (symbols.empty()) {
+                    if (const auto fallback = profile.fallback_options()) {
+                        symbols = convert::read_sheet(gray, *fallback, tiles);
+                    }
+                }
+                if (symbols.empty()) {
+                    return {{path, std::string{"无法识别条码或条码格式不正确"}}};
+                }
+
+                std::vector<convert::result_data_entry> results;
+                results.reserve(symbols.size());
+                const QFileInfo info(path);
+                for (std::size_t i = 0; i < symbols.size(); ++i) {
+                    const QString source = symbols.size() == 1
+                        ? path
+                        : info.dir().filePath(QString("%1_%2.%3").arg(info.completeBaseName()).arg(i + 1).arg(info.suffix()));
+                    try {
+                        results.push_back(decode_payload(source, convert::barcode_content(symbols[i].barcode), useBase64));
+                    } catch (const std::exception& e) {
+                        // 单个条码内容有误不影响同一页上的其它条码
+                        results.emplace_back(source, QString("解码失败:\n%1").arg(e.what()).toStdString());
+                    }
+                }
+                return results;
+            } catch (const std::exception& e) {
+                return {{path, QString("解码失败:\n%1").arg(e.what()).toStdString()}};
+            }
+        }
+    };
+
+    /**
+     * @brief 一条待保存的结果及其目标路径
+     */
+    struct save_task {
+        convert::result_data_entry entry;
+        QString                    dest;
+    };
+
+    struct save_result {
+        enum errcode {
+            success,
+            invalid_data,
+            failed,
+        };
+
+        errcode err;
+        QString path;
+    };
+
+    /**
+     * @brief 流水线中输入项的名称，阶段抛出异常时用于错误结果和日志
+     */
+    [[nodiscard]] inline QString pipeline_input_name(const file_part& part) {
+        return part.path;
+    }
+
+    [[nodiscard]] inline QString pipeline_input_name(const save_task& task) {
+        return task.dest;
+    }
+
+    /**
+     * @brief 阶段抛出异常时代替该项报告的结果，形式与各 worker 自己捕获异常时相同
+     */
+    [[nodiscard]] inline convert::result_data_entry pipeline_error_result(std::type_identity<convert::result_data_entry>,
+                                                                          const stage_error& error) {
+        return {error.input, QString("处理失败:\n%1").arg(QString::fromStdString(error.what)).toStdString()};
+    }
+
+    [[nodiscard]] inline std::vector<convert::result_data_entry> pipeline_error_result(
+        std::type_identity<std::vector<convert::result_data_entry>>, const stage_error& error) {
+        return {pipeline_error_result(std::type_identity<convert::result_data_entry>{}, error)};
+    }
+
+    [[nodiscard]] inline save_result pipeline_error_result(std::type_identity<save_result>, const stage_error& error) {
+        return {save_result::failed, error.input};
+    }
+
+    /**
+     * @brief 已编码、等待写入的文件
+     */
+    struct encoded_file {
+        QString dest;
+        QByteArray bytes;
+        save_result::errcode err = save_result::success; /**< 编码阶段已失败时不再写入，直接报告 */
+    };
+
+    /**
+     * @brief 保存的编码阶段：图片按 image 指定的格式编码到内存，字节数据原样传递
+     *
+     * 模块矩阵在这里才光栅化；保存为模块矩阵格式时直接取 1:1 的矩阵，不经过放大。
+     */
+    struct encode_worker {
+        using result_type = encoded_file;
+
+        convert::image_save_options image{}; /**< 图片格式与 PNG 压缩等级 */
+
+        encoded_file operator()(const save_task& task) const noexcept try {
+            return std::visit<encoded_file>(
+                overload_def_noop{std::in_place_type<encoded_file>,
+                    [&](const QImage& img) -> encoded_file {
+                        if (img.isNull())
+                            return {task.dest, {}, save_result::invalid_data};
+                        return encoded(task.dest,
+                            timing::timed(timing::stage::image_encode, [&] { return convert::encode_image(img, image); }));
+                    },
+                    [&](const convert::module_matrix& modules) { return (*this)(modules, task.dest); },
+                    [&](const QByteArray& data) -> encoded_file {
+                        if (data.isEmpty())
+                            return {task.dest, {}, save_result::invalid_data};
+                        return {task.dest, data};
+                    },
+                    [&](const auto&) noexcept { return encoded_file{task.dest, {}, save_result::failed}; }},
+                task.entry.data);
+        } catch (...) {
+            return {task.dest, {}, save_result::failed};
+        }
+
+        encoded_file operator()(const convert::module_matrix& modules, const QString& dest) const noexcept try {
+            if (modules.empty())
+                return {dest, {}, save_result::invalid_data};
+            const QImage img = timing::timed(timing::stage::rasterize,
+                [&] { return image.format == convert::image_format::modules ? modules.module_image() : modules.render(); });
+            return encoded(dest, timing::timed(timing::stage::image_encode, [&] { return convert::encode_image(img, image); }));
+        } catch (...) {
+            return {dest, {}, save_result::failed};
+        }
+
+    private:
+        static encoded_file encoded(const QString& dest, QByteArray bytes) {
+            // 编码失败（如图片没有模块网格信息）与直接 write_image 失败时一样按写入失败报告
+            if (bytes.isEmpty())
+                return {dest, {}, save_result::failed};
+            return {dest, std::move(bytes)};
+        }
+    };
+
+    /**
+     * @brief 保存的写入阶段：整个文件一次写出
+     */
+    struct write_worker {
+        using result_type = save_result;
+
+        bool sync = false; /**< 写完后刷到磁盘，之后要追加续跑日志记录时使用 */
+
+        save_result operator()(const encoded_file& file) const noexcept {
+            if (file.err != save_result::success)
+                return {file.err, file.dest};
+            const timing::scoped_timer timer(timing::stage::write);
+            QFile f(file.dest);
+            // 保持子目录层级时目标目录可能还不存在
+            const bool opened = f.open(QIODevice::WriteOnly)
+                || (QDir().mkpath(QFileInfo(file.dest).path()) && f.open(QIODevice::WriteOnly));
+            if (opened && f.write(file.bytes) == file.bytes.size() && (!sync || batch_journal::sync_file(f))) {
+                return {save_result::success, file.dest};
+            }
+            return {save_result::failed, file.dest};
+        }
+    };
+
+    /**
+     * @brief 将结果写入磁盘：编码与写入在同一线程中依次完成，供不分阶段的调用方（命令行工具）使用
+     */
+    struct save_worker {
+        using result_type = save_result;
+
+        convert::image_save_options image{}; /**< 图片格式与 PNG 压缩等级 */
+        bool sync = false;                   /**< 见 write_worker::sync */
+
+        save_result operator()(const save_task& task) const noexcept {
+            return write_worker{sync}(encode_worker{image}(task));
+        }
+    };
+
+    /**
+     * @brief 筛出文件中还需要生成的分片，跳过续跑日志中已成功完成的分片
+     *
+     * 分组 id 由文件路径、内容和拆分参数决定（见 sequence_group_id），输入不变时重新生成的分片与已写出的分片属于同一组，
+     * 只完成了一部分分片的文件接着生成即可。
+     * 大小和修改时间与记录一致时不读文件；修改时间不同时重新计算有记录的分片的哈希，
+     * 有分片内容变化，或还有分片没有记录、无法确认整个文件未变时，整个文件重做。
+     * 记录中的输出文件已被删除或为空（如写出后未落盘就掉电）时该分片重做。
+     *
+     * @return 为空表示整个文件已完成
+     */
+    [[nodiscard]] inline QList<file_part> journal_pending(const batch_journal& journal, const QList<file_part>& parts) {
+        if (parts.isEmpty()) {
+            return parts;
+        }
+        const auto stamp = batch_journal::input_stamp::of(parts.front().path);
+        QList<file_part> pending;
+        bool rehashed   = false;
+        bool unrecorded = false;
+        for (const auto& part : parts) {
+            const auto r = journal.find(part.path, part.sequence.index);
+            if (!r) {
+                unrecorded = true;
+                pending.append(part);
+                continue;
+            }
+            if (r->parts != part.sequence.total || r->size != stamp.size) {
+                return parts;
+            }
+            if (r->mtime != stamp.mtime) {
+                if (r->hash != batch_journal::hash_file(part.path, part.offset, part.length)) {
+                    return parts;
+                }
+                rehashed = true;
+            }
+            if (const QFileInfo output(r->output); !r->ok || r->output.isEmpty() || !output.isFile() || output.size() == 0) {
+                pending.append(part);
+            }
+        }
+        return rehashed && unrecorded ? parts : pending;
+    }
+
+    /**
+     * @class shared_output
+     * @brief 批次内去重时内容相同的文件共用的输出：第一个文件写出前持有编码好的内容，写出后只记住路径
+     *
+     * 复用者从已写出的文件复制（QFile::copy），去重保留的结果只占一个路径的内存，批次再大也不会攒下大量图片；
+     * 第一个文件尚未写出时复用者直接写入同一份内容（隐式共享，不复制）。所有接口线程安全。
+     */
+    class shared_output {
+    public:
+        explicit shared_output(QByteArray bytes) : bytes_(std::move(bytes)) {}
+
+        /**
+         * @brief 第一个文件的写入：写出后释放内容
+         * @param sync 见 write_worker::sync
+         */
+        save_result::errcode write_original(const QString& dest, bool sync) {
+            QByteArray bytes;
+            {
+                std::lock_guard lock(mutex_);
+                bytes = bytes_;
+            }
+            const auto err = write_worker{sync}(encoded_file{dest, std::move(bytes)}).err;
+            std::lock_guard lock(mutex_);
+            if (err == save_result::success) {
+                path_ = dest;
+            }
+            bytes_   = QByteArray{};
+            written_ = true;
+            return err;
+        }
+
+        /**
+         * @brief 复用者的写入：第一个文件已写出时复制它，否则写入同一份内容
+         */
+        save_result::errcode write_copy(const QString& dest, bool sync) const {
+            QString source;
+            QByteArray bytes;
+            {
+                std::lock_guard lock(mutex_);
+                if (written_ && path_.isEmpty()) {
+                    // 第一个文件写入失败，内容已经释放
+                    return save_result::failed;
+                }
+                source = path_;
+                bytes  = bytes_;
+            }
+            if (source.isEmpty()) {
+                return write_worker{sync}(encoded_file{dest, std::move(bytes)}).err;
+            }
+
+            const timing::scoped_timer timer(timing::stage::write);
+            QDir().mkpath(QFileInfo(dest).path());
+            // QFile::copy 不覆盖已有文件，与直接写入的行为保持一致
+            QFile::remove(dest);
+            return QFile::copy(source, dest) && (!sync || batch_journal::sync_path(dest)) ? save_result::success : save_result::failed;
+        }
+
+    private:
+        mutable std::mutex mutex_;
+        QByteArray bytes_; /**< 写出前的文件内容 */
+        QString path_;     /**< 成功写出的路径 */
+        bool written_ = false;
+    };
+
+    /**
+     * @brief 生成后等待写入的结果，模块矩阵已经编码为文件内容
+     */
+    struct pending_save {
+        convert::result_data_entry entry;
+        encoded_file file;     /**< dest 为空表示没有需要写入的内容（生成失败）；参与去重时 bytes 为空，内容在 shared 中 */
+        std::string inputHash; /**< 分片内容的 SHA-256，只在记录续跑日志时计算 */
+        batch_journal::input_stamp inputStamp; /**< 计算 inputHash 前输入文件的大小和修改时间 */
+        std::shared_ptr<shared_output> shared; /**< 参与去重时内容相同的文件共用的输出 */
+        bool reused = false;                   /**< 复用了别的文件的结果，写入时复制 */
+    };
+
+    /**
+     * @brief 生成后立即写入输出目录，结果只保留文件名、状态和缩略图
+     *
+     * 模块矩阵在工作线程中光栅化、编码后即释放，同时在内存中的只有在途任务数份文件内容。
+     * 缩略图直接按缩略图尺寸光栅化，总数受 thumbnails 限制，用完后结果中只记录保存路径，批次再大占用也有上限。
+     * generate 本身的 thumbnailSize 应为 0，缩略图只在这里按配额生成。
+     *
+     * 在流水线中，以 loaded_part 调用为转换阶段（生成并编码），以 pending_save 调用为写入阶段。
+     */
+    struct generate_save_worker {
+        using result_type = convert::result_data_entry;
+
+        generate_file_worker generate;
+        encode_worker encode;
+        QString outputDir;
+        std::shared_ptr<std::atomic<int>> thumbnails; /**< 剩余可保留的缩略图数量，各线程共享；为空时不保留 */
+        int thumbnailSize = 200;                      /**< 缩略图边长，与结果网格的单元格一致 */
+        std::shared_ptr<batch_journal> journal;       /**< 可选的续跑日志，每写完一项追加一条记录 */
+        std::shared_ptr<batch_dedup<pending_save>> dedup; /**< 可选的批次内去重，内容相同的整文件复用编码结果，写入时复制已写出的文件 */
+
+        convert::result_data_entry operator()(const file_part& part) const {
+            // 大小和修改时间须在读取之前取得，见 batch_journal::input_stamp
+            const auto stamp = journal ? batch_journal::input_stamp::of(part.path) : batch_journal::input_stamp{};
+            auto pending     = prepare(generate(part));
+            if (journal) {
+                pending.inputHash  = batch_journal::hash_file(part.path, part.offset, part.length);
+                pending.inputStamp = stamp;
+            }
+            return (*this)(std::move(pending));
+        }
+
+        pending_save operator()(const loaded_part& loaded) const {
+            const auto compute = [&] {
+                auto pending = prepare(generate(loaded));
+                if (journal && loaded.ok) {
+                    // 内容已在内存中，读取阶段没有算过摘要时在这里计算，不必再读文件
+                    pending.inputHash  = loaded.digest.empty() ? batch_journal::hash_bytes(loaded.part_bytes()) : loaded.digest;
+                    pending.inputStamp = loaded.stamp;
+                }
+                return pending;
+            };
+            // 与 generate_file_worker 相同，只对读取成功的整文件去重；generate 本身不应再设置 dedup
+            if (!dedup || !loaded.ok || loaded.part.sequence.total > 0 || loaded.digest.empty()) {
+                return compute();
+            }
+            auto [pending, shared] = dedup->share(loaded.digest, static_cast<std::uint64_t>(loaded.bytes.size()), [&] {
+                // 去重保留的结果中不带文件内容，内容交给 shared_output，第一个文件写出后即释放
+                auto first = compute();
+                if (!first.file.dest.isEmpty() && first.file.err == save_result::success) {
+                    first.shared = std::make_shared<shared_output>(std::exchange(first.file.bytes, QByteArray{}));
+                }
+                return first;
+            });
+            pending.reused = shared;
+            if (shared) {
+                pending.entry.source_file_name = loaded.part.path;
+                pending.entry.relative_dir     = loaded.part.relativeDir;
+                pending.inputStamp             = loaded.stamp;
+                if (!pending.file.dest.isEmpty()) {
+                    // 只换输出路径，写入阶段从第一个文件复制
+                    pending.file.dest = QDir(outputDir).filePath(pending.entry.get_default_target_path(encode.image.suffix()));
+                }
+            }
+            return std::move(pending);
+        }
+
+        convert::result_data_entry operator()(pending_save pending) const {
+            auto& res     = pending.entry;
+            // 记录续跑日志时先把文件刷到磁盘再追加记录
+            const bool sync  = journal != nullptr;
+            const auto write = [&] {
+                if (pending.shared) {
+                    return pending.reused ? pending.shared->write_copy(pending.file.dest, sync)
+                                          : pending.shared->write_original(pending.file.dest, sync);
+                }
+                return write_worker{sync}(pending.file).err;
+            };
+            const bool ok = !pending.file.dest.isEmpty() && write() == save_result::success;
+            if (ok) {
+                res.saved_path = pending.file.dest;
+            } else if (!pending.file.dest.isEmpty()) {
+                res.set_error("写入失败: " + pending.file.dest.toStdString());
+                res.thumbnail = QImage{};
+            }
+            if (journal) {
+                // 写盘之后才记录，崩溃时最多重做在途的几项
+                journal->append(batch_journal::make_record(res.source_file_name, res.sequence.index, res.sequence.total,
+                    pending.inputStamp, std::move(pending.inputHash), pending.file.dest, ok));
+            }
+            return std::move(res);
+        }
+
+    private:
+        pending_save prepare(convert::result_data_entry res) const {
+            const auto* modules = std::get_if<convert::module_matrix>(&res.data);
+            if (!modules) {
+                return {std::move(res)};
+            }
+
+            // 目录输入在输出目录中保持子目录层级，不同子目录中的同名文件不会互相覆盖
+            const QString dest = QDir(outputDir).filePath(res.get_default_target_path(encode.image.suffix()));
+            pending_save pending{{}, encode(*modules, dest)};
+            if (thumbnails && thumbnails->fetch_sub(1, std::memory_order_relaxed) > 0) {
+                const timing::scoped_timer timer(timing::stage::rasterize);
+                res.thumbnail = modules->thumbnail(thumbnailSize);
+            }
+            res.data      = QImage{};
+            pending.entry = std::move(res);
+            return pending;
+        }
+    };
+
+} // namespace workers